@@ -3851,6 +3851,263 @@ static void test_GdiAlphaBlend(void)
     HeapFree(GetProcessHeap(), 0, bmi);
 }
 
+/* Blending whole rows must give the same result as blending one pixel at a
+ * time, whatever the row width and the position of a pixel in it. */
+/* Helpers for the tests checking that drawing whole rows gives the same
+ * pixels as drawing one column at a time. */
+static HDC create_rows_dc(int width, int height, WORD bpp, BOOL rgb565, void **bits, HBITMAP *bmp)
+{
+    char buffer[FIELD_OFFSET(BITMAPINFO, bmiColors[3])];
+    BITMAPINFO *bmi = (BITMAPINFO *)buffer;
+    DWORD *masks = (DWORD *)bmi->bmiColors;
+    HDC hdc;
+
+    memset(buffer, 0, sizeof(buffer));
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biBitCount = bpp;
+    bmi->bmiHeader.biCompression = BI_RGB;
+    if (rgb565)
+    {
+        bmi->bmiHeader.biCompression = BI_BITFIELDS;
+        masks[0] = 0xf800;
+        masks[1] = 0x07e0;
+        masks[2] = 0x001f;
+    }
+
+    hdc = CreateCompatibleDC(NULL);
+    *bmp = CreateDIBSection(hdc, bmi, DIB_RGB_COLORS, bits, NULL, 0);
+    ok(*bmp != NULL, "Couldn't create %u-bpp bitmap\n", bpp);
+    SelectObject(hdc, *bmp);
+    return hdc;
+}
+
+static void fill_rows_bits(BYTE *bits, unsigned int size, unsigned int *seed)
+{
+    unsigned int i;
+
+    for (i = 0; i < size; ++i)
+    {
+        *seed = *seed * 1103515245 + 12345;
+        bits[i] = *seed >> 16;
+    }
+}
+
+static void test_GdiAlphaBlend_rows(void)
+{
+    static const BLENDFUNCTION blends[] =
+    {
+        {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA},
+        {AC_SRC_OVER, 0,  77, AC_SRC_ALPHA},
+        {AC_SRC_OVER, 0, 200, 0},
+    };
+    static const struct
+    {
+        WORD bpp;
+        BOOL rgb565;
+    }
+    formats[] =
+    {
+        {32},
+        {24},
+        {16},
+        {16, TRUE},
+    };
+    static const int width = 37, height = 3;
+    BYTE *dst_bits[2], *initial;
+    HBITMAP bmp_src, bmp_dst[2];
+    HDC hdc_src, hdc_dst[2];
+    unsigned int seed = 1, size;
+    unsigned int i, j, k;
+    DWORD *src_bits;
+    BYTE alpha;
+    BOOL ret;
+    int x;
+
+    if (!pGdiAlphaBlend)
+    {
+        win_skip("GdiAlphaBlend() is not implemented\n");
+        return;
+    }
+
+    hdc_src = create_rows_dc(width, height, 32, FALSE, (void **)&src_bits, &bmp_src);
+    for (i = 0; i < width * height; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        /* Mix transparent and opaque runs with premultiplied translucent pixels. */
+        switch ((seed >> 16) % 4)
+        {
+            case 0: src_bits[i] = 0; break;
+            case 1: src_bits[i] = 0xff000000 | seed; break;
+            default:
+                alpha = seed >> 24;
+                src_bits[i] = (DWORD)alpha << 24 | ((seed & 0xff) * alpha / 255) << 16
+                        | (((seed >> 8) & 0xff) * alpha / 255) << 8 | ((seed >> 16) & 0xff) * alpha / 255;
+                break;
+        }
+    }
+
+    for (k = 0; k < ARRAY_SIZE(formats); ++k)
+    {
+        for (i = 0; i < 2; ++i)
+            hdc_dst[i] = create_rows_dc(width, height, formats[k].bpp, formats[k].rgb565,
+                    (void **)&dst_bits[i], &bmp_dst[i]);
+
+        size = get_dib_stride(width, formats[k].bpp) * height;
+        initial = HeapAlloc(GetProcessHeap(), 0, size);
+        fill_rows_bits(initial, size, &seed);
+
+        for (i = 0; i < ARRAY_SIZE(blends); ++i)
+        {
+            for (j = 0; j < 2; ++j)
+                memcpy(dst_bits[j], initial, size);
+
+            ret = pGdiAlphaBlend(hdc_dst[0], 0, 0, width, height, hdc_src, 0, 0, width, height, blends[i]);
+            ok(ret, "%u-bpp test %u: GdiAlphaBlend failed, error %u.\n", formats[k].bpp, i, GetLastError());
+            for (x = 0; x < width; ++x)
+            {
+                ret = pGdiAlphaBlend(hdc_dst[1], x, 0, 1, height, hdc_src, x, 0, 1, height, blends[i]);
+                ok(ret, "%u-bpp test %u: GdiAlphaBlend failed, error %u.\n", formats[k].bpp, i, GetLastError());
+            }
+            GdiFlush();
+
+            for (j = 0; j < size; ++j)
+            {
+                if (dst_bits[0][j] != dst_bits[1][j])
+                    break;
+            }
+            ok(j == size, "%u-bpp test %u: got %02x, expected %02x at %u.\n", formats[k].bpp, i,
+                    j < size ? dst_bits[0][j] : 0, j < size ? dst_bits[1][j] : 0, j);
+        }
+
+        HeapFree(GetProcessHeap(), 0, initial);
+        for (i = 0; i < 2; ++i)
+        {
+            DeleteDC(hdc_dst[i]);
+            DeleteObject(bmp_dst[i]);
+        }
+    }
+
+    DeleteDC(hdc_src);
+    DeleteObject(bmp_src);
+}
+
+static void test_PatBlt_rows(void)
+{
+    static const DWORD rops[] =
+    {
+        PATINVERT, DSTINVERT, 0x00a000c9 /* DPa */, 0x00fa0089 /* DPo */, 0x000a0329 /* DPna */,
+    };
+    static const int width = 37, height = 3;
+    BYTE *dst_bits[2], *initial;
+    unsigned int seed = 1, size;
+    HBITMAP bmp_dst[2];
+    HBRUSH brush;
+    HDC hdc_dst[2];
+    unsigned int i, j;
+    BOOL ret;
+    int x;
+
+    size = get_dib_stride(width, 32) * height;
+    initial = HeapAlloc(GetProcessHeap(), 0, size);
+    fill_rows_bits(initial, size, &seed);
+    brush = CreateSolidBrush(RGB(0x12, 0xc5, 0x6a));
+    for (i = 0; i < 2; ++i)
+    {
+        hdc_dst[i] = create_rows_dc(width, height, 32, FALSE, (void **)&dst_bits[i], &bmp_dst[i]);
+        SelectObject(hdc_dst[i], brush);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(rops); ++i)
+    {
+        for (j = 0; j < 2; ++j)
+            memcpy(dst_bits[j], initial, size);
+
+        ret = PatBlt(hdc_dst[0], 0, 0, width, height, rops[i]);
+        ok(ret, "Rop %#x: PatBlt failed, error %u.\n", rops[i], GetLastError());
+        for (x = 0; x < width; ++x)
+        {
+            ret = PatBlt(hdc_dst[1], x, 0, 1, height, rops[i]);
+            ok(ret, "Rop %#x: PatBlt failed, error %u.\n", rops[i], GetLastError());
+        }
+        GdiFlush();
+
+        ok(!memcmp(dst_bits[0], dst_bits[1], size), "Rop %#x: rows and columns differ.\n", rops[i]);
+    }
+
+    HeapFree(GetProcessHeap(), 0, initial);
+    for (i = 0; i < 2; ++i)
+    {
+        DeleteDC(hdc_dst[i]);
+        DeleteObject(bmp_dst[i]);
+    }
+    DeleteObject(brush);
+}
+
+static void test_ExtTextOut_rows(void)
+{
+    static const char str[] = "Hello Wine";
+    static const int width = 128, height = 32;
+    BYTE *dst_bits[2], *initial;
+    unsigned int seed = 1, size;
+    HBITMAP bmp_dst[2];
+    HFONT font, old_font[2];
+    TEXTMETRICA tm;
+    HDC hdc_dst[2];
+    unsigned int i;
+    LOGFONTA lf;
+    RECT rect;
+    int x;
+
+    memset(&lf, 0, sizeof(lf));
+    strcpy(lf.lfFaceName, "Tahoma");
+    lf.lfHeight = 24;
+    lf.lfQuality = ANTIALIASED_QUALITY;
+    font = CreateFontIndirectA(&lf);
+
+    size = get_dib_stride(width, 32) * height;
+    initial = HeapAlloc(GetProcessHeap(), 0, size);
+    fill_rows_bits(initial, size, &seed);
+    for (i = 0; i < 2; ++i)
+    {
+        hdc_dst[i] = create_rows_dc(width, height, 32, FALSE, (void **)&dst_bits[i], &bmp_dst[i]);
+        old_font[i] = SelectObject(hdc_dst[i], font);
+        SetTextColor(hdc_dst[i], RGB(0xff, 0x40, 0x00));
+        SetBkMode(hdc_dst[i], TRANSPARENT);
+        memcpy(dst_bits[i], initial, size);
+    }
+
+    GetTextMetricsA(hdc_dst[0], &tm);
+    if (!(tm.tmPitchAndFamily & TMPF_VECTOR))
+    {
+        skip("skipping as a bitmap font has been selected for Tahoma.\n");
+        goto done;
+    }
+
+    ExtTextOutA(hdc_dst[0], 2, 2, 0, NULL, str, strlen(str), NULL);
+    for (x = 0; x < width; ++x)
+    {
+        SetRect(&rect, x, 0, x + 1, height);
+        ExtTextOutA(hdc_dst[1], 2, 2, ETO_CLIPPED, &rect, str, strlen(str), NULL);
+    }
+    GdiFlush();
+
+    ok(memcmp(dst_bits[0], initial, size), "Text wasn't drawn.\n");
+    ok(!memcmp(dst_bits[0], dst_bits[1], size), "Rows and columns differ.\n");
+
+done:
+    HeapFree(GetProcessHeap(), 0, initial);
+    for (i = 0; i < 2; ++i)
+    {
+        SelectObject(hdc_dst[i], old_font[i]);
+        DeleteDC(hdc_dst[i]);
+        DeleteObject(bmp_dst[i]);
+    }
+    DeleteObject(font);
+}
+
 static void test_GdiGradientFill(void)
 {
     HDC hdc;
@@ -6006,6 +6263,9 @@ START_TEST(bitmap)
     test_StretchBlt();
     test_StretchDIBits();
     test_GdiAlphaBlend();
+    test_GdiAlphaBlend_rows();
+    test_PatBlt_rows();
+    test_ExtTextOut_rows();
     test_GdiGradientFill();
     test_32bit_ddb();
     test_bitmapinfoheadersize();
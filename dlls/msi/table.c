@@ -39,14 +39,25 @@
 WINE_DEFAULT_DEBUG_CHANNEL(msidb);
 
 #define MSITABLE_HASH_TABLE_SIZE 37
+#define MSITABLE_HASH_END (~0u)
 
 typedef struct tagMSICOLUMNHASHENTRY
 {
-    struct tagMSICOLUMNHASHENTRY *next;
+    UINT next;  /* index of the next entry in the same bucket */
     UINT value;
     UINT row;
 } MSICOLUMNHASHENTRY;
 
+/* index of the rows of a table by column value, built on first lookup */
+typedef struct tagMSICOLUMNHASH
+{
+    UINT bucket_count;
+    UINT entry_count;
+    UINT entry_size;
+    UINT *buckets;
+    MSICOLUMNHASHENTRY *entries;
+} MSICOLUMNHASH;
+
 typedef struct tagMSICOLUMNINFO
 {
     LPCWSTR tablename;
@@ -54,7 +65,7 @@ typedef struct tagMSICOLUMNINFO
     LPCWSTR colname;
     UINT    type;
     UINT    offset;
-    MSICOLUMNHASHENTRY **hash_table;
+    MSICOLUMNHASH *hash_table;
 } MSICOLUMNINFO;
 
 struct tagMSITABLE
@@ -354,10 +365,21 @@ end:
     return ret;
 }
 
+static void free_column_hash( MSICOLUMNINFO *colinfo )
+{
+    MSICOLUMNHASH *hash = colinfo->hash_table;
+
+    if (!hash) return;
+    msi_free( hash->buckets );
+    msi_free( hash->entries );
+    msi_free( hash );
+    colinfo->hash_table = NULL;
+}
+
 static void msi_free_colinfo( MSICOLUMNINFO *colinfo, UINT count )
 {
     UINT i;
-    for (i = 0; i < count; i++) msi_free( colinfo[i].hash_table );
+    for (i = 0; i < count; i++) free_column_hash( &colinfo[i] );
 }
 
 static void free_table( MSITABLE *table )
@@ -1154,6 +1176,110 @@ static UINT TABLE_fetch_stream( struct tagMSIVIEW *view, UINT row, UINT col, ISt
     return r;
 }
 
+static BOOL column_hash_add( MSICOLUMNHASH *hash, UINT row, UINT value )
+{
+    MSICOLUMNHASHENTRY *entry;
+    UINT bucket = value % hash->bucket_count;
+
+    /* let the index be rebuilt with more buckets once the chains get long */
+    if (hash->entry_count >= 4 * hash->bucket_count)
+        return FALSE;
+
+    if (hash->entry_count == hash->entry_size)
+    {
+        UINT size = hash->entry_size * 2;
+        MSICOLUMNHASHENTRY *entries = msi_realloc( hash->entries, size * sizeof(*entries) );
+
+        if (!entries)
+            return FALSE;
+        hash->entries = entries;
+        hash->entry_size = size;
+    }
+
+    entry = &hash->entries[hash->entry_count];
+    entry->value = value;
+    entry->row = row;
+    entry->next = hash->buckets[bucket];
+    hash->buckets[bucket] = hash->entry_count++;
+    return TRUE;
+}
+
+static void column_hash_remove( MSICOLUMNHASH *hash, UINT row, UINT value )
+{
+    UINT *index = &hash->buckets[value % hash->bucket_count];
+
+    while (*index != MSITABLE_HASH_END)
+    {
+        MSICOLUMNHASHENTRY *entry = &hash->entries[*index];
+
+        if (entry->row == row && entry->value == value)
+        {
+            *index = entry->next;
+            return;
+        }
+        index = &entry->next;
+    }
+}
+
+static UINT table_build_column_hash( MSITABLEVIEW *tv, UINT col )
+{
+    MSICOLUMNINFO *colinfo = &tv->columns[col - 1];
+    MSICOLUMNHASH *hash;
+    UINT i, r, val;
+
+    TRACE("building index of %s.%s\n", debugstr_w(tv->name), debugstr_w(colinfo->colname));
+
+    if (!(hash = msi_alloc( sizeof(*hash) )))
+        return ERROR_OUTOFMEMORY;
+
+    hash->bucket_count = max( MSITABLE_HASH_TABLE_SIZE, tv->table->row_count );
+    hash->entry_count = 0;
+    hash->entry_size = max( MSITABLE_HASH_TABLE_SIZE, tv->table->row_count );
+    hash->buckets = msi_alloc( hash->bucket_count * sizeof(*hash->buckets) );
+    hash->entries = msi_alloc( hash->entry_size * sizeof(*hash->entries) );
+    if (!hash->buckets || !hash->entries)
+    {
+        msi_free( hash->buckets );
+        msi_free( hash->entries );
+        msi_free( hash );
+        return ERROR_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < hash->bucket_count; i++)
+        hash->buckets[i] = MSITABLE_HASH_END;
+
+    colinfo->hash_table = hash;
+    for (i = 0; i < tv->table->row_count; i++)
+    {
+        if ((r = TABLE_fetch_int( &tv->view, i, col, &val )))
+        {
+            free_column_hash( colinfo );
+            return r;
+        }
+        column_hash_add( hash, i, val );
+    }
+    return ERROR_SUCCESS;
+}
+
+/* keep the column indices in sync with a row inserted at the given position */
+static void table_hash_insert_row( MSITABLEVIEW *tv, UINT row )
+{
+    UINT i, j, val;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        MSICOLUMNHASH *hash = tv->columns[i].hash_table;
+
+        if (!hash) continue;
+
+        for (j = 0; j < hash->entry_count; j++)
+            if (hash->entries[j].row >= row) hash->entries[j].row++;
+
+        if (TABLE_fetch_int( &tv->view, row, i + 1, &val ) || !column_hash_add( hash, row, val ))
+            free_column_hash( &tv->columns[i] );
+    }
+}
+
 /* Set a table value, i.e. preadjusted integer or string ID. */
 static UINT table_set_bytes( MSITABLEVIEW *tv, UINT row, UINT col, UINT val )
 {
@@ -1175,8 +1301,19 @@ static UINT table_set_bytes( MSITABLEVIEW *tv, UINT row, UINT col, UINT val )
         return ERROR_FUNCTION_FAILED;
     }
 
-    msi_free( tv->columns[col-1].hash_table );
-    tv->columns[col-1].hash_table = NULL;
+    if (tv->columns[col-1].hash_table)
+    {
+        UINT old;
+
+        if (TABLE_fetch_int( &tv->view, row, col, &old ))
+            free_column_hash( &tv->columns[col-1] );
+        else if (old != val)
+        {
+            column_hash_remove( tv->columns[col-1].hash_table, row, old );
+            if (!column_hash_add( tv->columns[col-1].hash_table, row, val ))
+                free_column_hash( &tv->columns[col-1] );
+        }
+    }
 
     n = bytes_per_column( tv->db, &tv->columns[col - 1], LONG_STR_BYTES );
     if ( n != 2 && n != 3 && n != 4 )
@@ -1731,6 +1868,7 @@ static UINT TABLE_insert_row( struct tagMSIVIEW *view, MSIRECORD *rec, UINT row,
                 &(tv->table->data[i - 1][0]), tv->row_size);
         tv->table->data_persistent[i] = tv->table->data_persistent[i - 1];
     }
+    table_hash_insert_row( tv, row );
 
     /* Re-set the persistence flag */
     tv->table->data_persistent[row] = !temporary;
@@ -1759,10 +1897,7 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
 
     /* reset the hash tables */
     for (i = 0; i < tv->num_cols; i++)
-    {
-        msi_free( tv->columns[i].hash_table );
-        tv->columns[i].hash_table = NULL;
-    }
+        free_column_hash( &tv->columns[i] );
 
     for (i = row + 1; i < num_rows; i++)
     {
@@ -1946,6 +2081,7 @@ static UINT TABLE_remove_column(struct tagMSIVIEW *view, UINT number)
     if (tv->table->colinfo[number-1].type & MSITYPE_TEMPORARY)
     {
         UINT size = tv->table->colinfo[number-1].offset;
+        free_column_hash( &tv->table->colinfo[number-1] );
         tv->table->col_count--;
         tv->table->colinfo = msi_realloc( tv->table->colinfo, sizeof(*tv->table->colinfo) * tv->table->col_count );
 
@@ -2164,6 +2300,47 @@ done:
     return r;
 }
 
+static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row, MSIITERHANDLE *handle )
+{
+    MSITABLEVIEW *tv = (MSITABLEVIEW *)view;
+    const MSICOLUMNHASHENTRY *entry;
+    const MSICOLUMNHASH *hash;
+    UINT index, r;
+
+    TRACE("%p, %u, %u, %p\n", view, col, val, *handle);
+
+    if (!tv->table)
+        return ERROR_INVALID_PARAMETER;
+
+    if (col == 0 || col > tv->num_cols)
+        return ERROR_INVALID_PARAMETER;
+
+    if (!tv->columns[col - 1].hash_table && (r = table_build_column_hash( tv, col )))
+        return r;
+    hash = tv->columns[col - 1].hash_table;
+
+    if (!*handle)
+        index = hash->buckets[val % hash->bucket_count];
+    else
+        index = (*handle)->next;
+
+    for (entry = NULL; index != MSITABLE_HASH_END; index = entry->next)
+    {
+        entry = &hash->entries[index];
+        if (entry->value == val) break;
+    }
+
+    if (index == MSITABLE_HASH_END)
+    {
+        *handle = NULL;
+        return ERROR_NO_MORE_ITEMS;
+    }
+
+    *handle = entry;
+    *row = entry->row;
+    return ERROR_SUCCESS;
+}
+
 static const MSIVIEWOPS table_ops =
 {
     TABLE_fetch_int,
@@ -2185,6 +2362,7 @@ static const MSIVIEWOPS table_ops =
     TABLE_add_column,
     NULL,
     TABLE_drop,
+    TABLE_find_matching_rows,
 };
 
 UINT TABLE_CreateView( MSIDATABASE *db, LPCWSTR name, MSIVIEW **view )
@@ -2767,7 +2945,7 @@ UINT TransformView_Create( MSIDATABASE *db, string_table *st, LPCWSTR name, MSIV
     static const WCHAR query_sfx[] = L"' AND `Row` IS NULL AND `Current` IS NOT NULL AND `new` = 1";
 
     WCHAR buf[256], *query = buf;
-    UINT r, len, name_len, size, add_col;
+    UINT r, len, name_len, size, add_col, i;
     MSICOLUMNINFO *colinfo;
     MSITABLEVIEW *tv;
     MSIRECORD *rec;
@@ -2877,6 +3055,8 @@ UINT TransformView_Create( MSIDATABASE *db, string_table *st, LPCWSTR name, MSIV
     msiobj_release( &q->hdr );
 
     memcpy( colinfo, tv->columns, tv->num_cols * sizeof(*colinfo) );
+    /* the column indices belong to the table */
+    for (i = 0; i < tv->num_cols; i++) colinfo[i].hash_table = NULL;
     tv->columns = colinfo;
     tv->num_cols += add_col;
     return ERROR_SUCCESS;
@@ -3146,11 +3326,35 @@ static UINT msi_row_matches( MSITABLEVIEW *tv, UINT row, const UINT *data, UINT
 
 static UINT msi_table_find_row( MSITABLEVIEW *tv, MSIRECORD *rec, UINT *row, UINT *column )
 {
-    UINT i, r = ERROR_FUNCTION_FAILED, *data;
+    UINT i, r = ERROR_FUNCTION_FAILED, *data, match, key_col, match_col;
+    MSIITERHANDLE handle = NULL;
 
     data = msi_record_to_row( tv, rec );
     if( !data )
         return r;
+
+    for (key_col = 0; key_col < tv->num_cols; key_col++)
+        if (tv->columns[key_col].type & MSITYPE_KEY) break;
+
+    if (key_col < tv->num_cols &&
+        (tv->columns[key_col].hash_table || !table_build_column_hash( tv, key_col + 1 )))
+    {
+        /* only check the rows matching the first key column, keeping the first one; the hash
+         * chain isn't in row order, so partial matches of other rows must not change *column */
+        while (!TABLE_find_matching_rows( &tv->view, key_col + 1, data[key_col], &match, &handle ))
+        {
+            if (r == ERROR_SUCCESS && match > *row) continue;
+            if (msi_row_matches( tv, match, data, &match_col ) == ERROR_SUCCESS)
+            {
+                *row = match;
+                if (column) *column = match_col;
+                r = ERROR_SUCCESS;
+            }
+        }
+        msi_free( data );
+        return r;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = msi_row_matches( tv, i, data, column );
@@ -646,16 +646,105 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static BOOL is_table_column( const struct expr *expr, const JOINTABLE *table )
+{
+    return (expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+            expr->type == EXPR_COL_NUMBER_STRING) && expr->u.column.parsed.table == table;
+}
+
+/* look for an equality between a column of the table and a known value,
+ * so that only the rows holding that value need to be evaluated */
+static BOOL find_join_value( MSIWHEREVIEW *wv, const struct expr *cond, const JOINTABLE *table,
+                             const UINT rows[], UINT *col, UINT *val )
+{
+    const struct expr *column, *other;
+
+    if (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP)
+        return FALSE;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+        return find_join_value( wv, cond->u.expr.left, table, rows, col, val ) ||
+               find_join_value( wv, cond->u.expr.right, table, rows, col, val );
+
+    if (cond->u.expr.op != OP_EQ)
+        return FALSE;
+
+    column = cond->u.expr.left;
+    other = cond->u.expr.right;
+    if (!is_table_column( column, table ))
+    {
+        column = cond->u.expr.right;
+        other = cond->u.expr.left;
+        if (!is_table_column( column, table ))
+            return FALSE;
+    }
+
+    switch (other->type)
+    {
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        if (other->type != column->type || other->u.column.parsed.table == table)
+            return FALSE;
+        if (expr_fetch_value( &other->u.column, rows, val ) != ERROR_SUCCESS)
+            return FALSE;
+        /* null and empty strings compare equal */
+        if (column->type == EXPR_COL_NUMBER_STRING && !*val)
+            return FALSE;
+        break;
+    case EXPR_UVAL:
+        if (column->type == EXPR_COL_NUMBER)
+        {
+            if ((other->u.uval + 0x8000) & 0xffff0000)
+                return FALSE;
+            *val = other->u.uval + 0x8000;
+        }
+        else if (column->type == EXPR_COL_NUMBER32)
+            *val = other->u.uval + 0x80000000;
+        else
+            return FALSE;
+        break;
+    case EXPR_SVAL:
+        if (column->type != EXPR_COL_NUMBER_STRING || !other->u.sval[0])
+            return FALSE;
+        if (msi_string2id( wv->db->strings, other->u.sval, -1, val ) != ERROR_SUCCESS)
+            return FALSE;
+        break;
+    default:
+        return FALSE;
+    }
+
+    *col = column->u.column.parsed.column;
+    return TRUE;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    MSIVIEW *view = (*tables)->view;
+    UINT *row = &table_rows[(*tables)->table_index];
+    UINT r = ERROR_FUNCTION_FAILED, col, key;
+    MSIITERHANDLE handle = NULL;
+    BOOL indexed = FALSE;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (view->ops->find_matching_rows && wv->cond &&
+        find_join_value( wv, wv->cond, *tables, table_rows, &col, &key ))
     {
+        indexed = TRUE;
+        r = ERROR_SUCCESS;
+    }
+
+    for (*row = 0;; (*row)++)
+    {
+        if (indexed)
+        {
+            if (view->ops->find_matching_rows( view, col, key, row, &handle ) != ERROR_SUCCESS)
+                break;
+        }
+        else if (*row >= (*tables)->row_count)
+            break;
+
         val = 0;
         wv->rec_index = 0;
         r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
@@ -677,7 +766,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **ta
             }
         }
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    *row = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -34,6 +34,7 @@
 #undef wcsncpy
 
 extern BOOL sse2_supported DECLSPEC_HIDDEN;
+extern BOOL erms_supported DECLSPEC_HIDDEN;
 
 #define DBL80_MAX_10_EXP 4932
 #define DBL80_MIN_10_EXP -4951
@@ -1507,14 +1507,61 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
     return _atoldbl_l( (MSVCRT__LDOUBLE*)value, str, NULL );
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+/* Return a mask of the bytes of the 16-byte aligned block at p that are either
+ * zero or equal to the corresponding byte of pattern. Aligned loads never cross
+ * a page boundary, so reading past the terminator is safe. */
+static inline unsigned int sse2_find_bytes(const char *p, const void *pattern)
+{
+    unsigned int mask;
+    __asm__( "movdqu (%2), %%xmm2\n\t"
+             "movdqa (%1), %%xmm1\n\t"
+             "pxor %%xmm0, %%xmm0\n\t"
+             "pcmpeqb %%xmm1, %%xmm0\n\t"
+             "pcmpeqb %%xmm1, %%xmm2\n\t"
+             "por %%xmm2, %%xmm0\n\t"
+             "pmovmskb %%xmm0, %0"
+             : "=r" (mask) : "r" (p), "r" (pattern) : "xmm0", "xmm1", "xmm2", "memory" );
+    return mask;
+}
+
+/* find the first byte of str that is either zero or c */
+static inline const char *sse2_strchrnul(const char *str, int c)
+{
+    const char *p = (const char *)((ULONG_PTR)str & ~15);
+    unsigned char pattern[16];
+    unsigned int mask;
+    DWORD pos;
+
+    memset(pattern, c, sizeof(pattern));
+    mask = sse2_find_bytes(p, pattern) >> (str - p);
+    if (BitScanForward(&pos, mask)) return str + pos;
+    for (;;)
+    {
+        p += 16;
+        if (BitScanForward(&pos, sse2_find_bytes(p, pattern))) return p + pos;
+    }
+}
+
+#endif
+
 /*********************************************************************
  *              strlen (MSVCRT.@)
  */
 size_t __cdecl strlen(const char *str)
 {
+#ifdef __x86_64__
+    return sse2_strchrnul(str, 0) - str;
+#else
     const char *s = str;
+
+#ifdef __i386__
+    if (sse2_supported) return sse2_strchrnul(str, 0) - str;
+#endif
     while (*s) s++;
     return s - str;
+#endif
 }
 
 /******************************************************************
@@ -2680,9 +2727,38 @@ int CDECL I10_OUTPUT(MSVCRT__LDOUBLE ld80, int prec, int flag, struct _I10_OUTPU
  */
 int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
 {
-    const unsigned char *p1, *p2;
+    typedef size_t DECLSPEC_ALIGN(1) unaligned_size_t;
+    const unsigned char *p1 = ptr1, *p2 = ptr2;
 
-    for (p1 = ptr1, p2 = ptr2; n; n--, p1++, p2++)
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef __i386__
+    if (sse2_supported)
+#endif
+    {
+        unsigned int mask;
+        DWORD pos;
+
+        /* compare 16 bytes at a time, pcmpeqb sets a mask bit for each identical byte */
+        for (; n >= 16; n -= 16, p1 += 16, p2 += 16)
+        {
+            __asm__( "movdqu (%1), %%xmm0\n\t"
+                     "movdqu (%2), %%xmm1\n\t"
+                     "pcmpeqb %%xmm1, %%xmm0\n\t"
+                     "pmovmskb %%xmm0, %0"
+                     : "=r" (mask) : "r" (p1), "r" (p2) : "xmm0", "xmm1", "memory" );
+            if (BitScanForward(&pos, ~mask & 0xffff))
+                return p1[pos] < p2[pos] ? -1 : 1;
+        }
+    }
+#endif
+    /* skip the identical words, the first difference is found byte by byte */
+    while (n >= sizeof(size_t) && *(const unaligned_size_t *)p1 == *(const unaligned_size_t *)p2)
+    {
+        p1 += sizeof(size_t);
+        p2 += sizeof(size_t);
+        n -= sizeof(size_t);
+    }
+    for (; n; n--, p1++, p2++)
     {
         if (*p1 < *p2) return -1;
         if (*p1 > *p2) return 1;
@@ -2692,6 +2768,19 @@ int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
 
 #if defined(__i386__) || defined(__x86_64__)
 
+/* minimum size for using rep movsb/stosb, which is faster than the SSE2 loops on large blocks */
+#define ERMS_MIN_SIZE 2048
+
+static inline void erms_memcpy(void *dst, const void *src, size_t n)
+{
+    __asm__ __volatile__( "rep; movsb" : "+D" (dst), "+S" (src), "+c" (n) : : "memory" );
+}
+
+static inline void erms_memset(void *dst, int c, size_t n)
+{
+    __asm__ __volatile__( "rep; stosb" : "+D" (dst), "+c" (n) : "a" (c) : "memory" );
+}
+
 #ifdef __i386__
 
 #define DEST_REG "%edi"
@@ -2958,6 +3047,13 @@ __ASM_GLOBAL_FUNC( sse2_memmove,
 #endif
 void * __cdecl memmove(void *dst, const void *src, size_t n)
 {
+#if defined(__i386__) || defined(__x86_64__)
+    if (n >= ERMS_MIN_SIZE && erms_supported && (size_t)dst - (size_t)src >= n)
+    {
+        erms_memcpy(dst, src, n);
+        return dst;
+    }
+#endif
 #ifdef __x86_64__
     return sse2_memmove(dst, src, n);
 #else
@@ -3172,6 +3268,13 @@ void *__cdecl memset(void *dst, int c, size_t n)
     unsigned char *d = (unsigned char *)dst;
     size_t a = 0x20 - ((uintptr_t)d & 0x1f);
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (n >= ERMS_MIN_SIZE && erms_supported)
+    {
+        erms_memset(d, c, n);
+        return dst;
+    }
+#endif
     if (n >= 16)
     {
         *(unaligned_ui64 *)(d + 0) = v;
@@ -3234,6 +3337,15 @@ void *__cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
+#if defined(__i386__) || defined(__x86_64__)
+#ifdef __i386__
+    if (sse2_supported)
+#endif
+    {
+        str = sse2_strchrnul(str, c);
+        return *str == (char)c ? (char*)str : NULL;
+    }
+#endif
     do
     {
         if (*str == (char)c) return (char*)str;
@@ -2877,6 +2877,27 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
 size_t CDECL wcslen(const wchar_t *str)
 {
     const wchar_t *s = str;
+
+#if defined(__i386__) || defined(__x86_64__)
+    /* scan the aligned 16-byte blocks containing the string, which never cross a page */
+    if (sse2_supported && !((ULONG_PTR)str & 1))
+    {
+        const wchar_t *p = (const wchar_t *)((ULONG_PTR)str & ~15);
+        unsigned int mask;
+        DWORD pos;
+
+        for (;;)
+        {
+            __asm__( "pxor %%xmm0, %%xmm0\n\t"
+                     "pcmpeqw (%1), %%xmm0\n\t"
+                     "pmovmskb %%xmm0, %0"
+                     : "=r" (mask) : "r" (p) : "xmm0", "memory" );
+            if (p < str) mask &= ~0u << ((str - p) * sizeof(wchar_t));
+            if (BitScanForward(&pos, mask)) return p + pos / sizeof(wchar_t) - str;
+            p += 16 / sizeof(wchar_t);
+        }
+    }
+#endif
     while (*s) s++;
     return s - str;
 }
@@ -38,6 +38,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
+WINE_DECLARE_DEBUG_CHANNEL(heapstats);
 
 /* Note: the heap data structures are loosely based on what Pietrek describes in his
  * book 'Windows 95 System Programming Secrets', with some adaptations for
@@ -163,6 +164,11 @@ typedef struct tagHEAP
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
     int              extended_type; /* Extended heap type */
+    LONG             contention;    /* Number of contended allocations */
+    SIZE_T           alloc_count;   /* Statistics, only collected with +heapstats */
+    SIZE_T           free_count;
+    SIZE_T           live_bytes;
+    SIZE_T           peak_bytes;
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -170,10 +176,13 @@ typedef struct tagHEAP
 #define HEAP_DEF_SIZE        0x110000   /* Default heap size = 1Mb + 64Kb */
 #define COMMIT_MASK          0xffff  /* bitmask for commit/decommit granularity */
 #define MAX_FREE_PENDING     1024    /* max number of free requests to delay */
+#define LFH_CONTENTION_COUNT 64      /* contended allocations before enabling the LFH */
+#define HEAP_SAMPLE_INTERVAL 0x80000 /* allocated bytes between two +heapstats samples */
 
 BOOL delay_heap_free = FALSE;
 
 static HEAP *processHeap;  /* main process heap */
+static SIZE_T heap_sample_bytes;  /* bytes allocated since the last +heapstats sample */
 
 static BOOL HEAP_IsRealArena( HEAP *heapPtr, DWORD flags, LPCVOID block, BOOL quiet );
 
@@ -925,6 +934,11 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->flags         = flags;
         heap->magic         = HEAP_MAGIC;
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
+        heap->contention    = 0;
+        heap->alloc_count   = 0;
+        heap->free_count    = 0;
+        heap->live_bytes    = 0;
+        heap->peak_bytes    = 0;
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
 
@@ -1507,6 +1521,43 @@ static void heap_set_debug_flags( HANDLE handle )
 }
 
 
+/* record an allocation in the heap statistics, and sample its backtrace
+ * once every HEAP_SAMPLE_INTERVAL allocated bytes */
+static void heap_stats_alloc( HEAP *heap, SIZE_T size, void *ptr )
+{
+    SIZE_T live, prev;
+    void *frames[16];
+    USHORT i, count;
+
+    __atomic_fetch_add( &heap->alloc_count, 1, __ATOMIC_RELAXED );
+    live = __atomic_add_fetch( &heap->live_bytes, size, __ATOMIC_RELAXED );
+    if (live > heap->peak_bytes) heap->peak_bytes = live;
+
+    prev = __atomic_fetch_add( &heap_sample_bytes, size, __ATOMIC_RELAXED );
+    if ((prev + size) / HEAP_SAMPLE_INTERVAL == prev / HEAP_SAMPLE_INTERVAL) return;
+
+    count = RtlCaptureStackBackTrace( 2, ARRAY_SIZE(frames), frames, NULL );
+    TRACE_(heapstats)( "sample heap %p size %#Ix ptr %p backtrace", heap, size, ptr );
+    for (i = 0; i < count; i++) TRACE_(heapstats)( " %p", frames[i] );
+    TRACE_(heapstats)( "\n" );
+}
+
+static void heap_stats_free( HEAP *heap, SIZE_T size )
+{
+    __atomic_fetch_add( &heap->free_count, 1, __ATOMIC_RELAXED );
+    __atomic_fetch_sub( &heap->live_bytes, size, __ATOMIC_RELAXED );
+}
+
+static void heap_dump_stats( HEAP *heap )
+{
+    TRACE_(heapstats)( "heap %p type %u: %Iu allocs, %Iu frees, %Iu live bytes, %Iu peak bytes, "
+                       "%u subheaps, %u large blocks, %d contended allocs\n",
+                       heap, heap->extended_type, heap->alloc_count, heap->free_count, heap->live_bytes,
+                       heap->peak_bytes, list_count( &heap->subheap_list ), list_count( &heap->large_list ),
+                       heap->contention );
+}
+
+
 /***********************************************************************
  *           RtlCreateHeap   (NTDLL.@)
  *
@@ -1591,6 +1642,7 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     if (!heapPtr) return heap;
 
     if (heap == processHeap) return heap; /* cannot delete the main process heap */
+    if (TRACE_ON(heapstats)) heap_dump_stats( heapPtr );
 
     /* remove it from the per-process list */
     RtlEnterCriticalSection( &processHeap->critSection );
@@ -1625,6 +1677,23 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
 }
 
 
+/* Like Windows, switch the process heap to the per-thread low fragmentation
+ * heap once its lock gets contended, unless heap debugging is enabled. */
+static void enter_alloc_critical_section( HEAP *heap )
+{
+    if (RtlTryEnterCriticalSection( &heap->critSection )) return;
+    RtlEnterCriticalSection( &heap->critSection );
+
+    if (++heap->contention < LFH_CONTENTION_COUNT) return;
+    if (heap != processHeap || heap->extended_type != HEAP_STD) return;
+    if (heap->pending_free || (heap->flags & (HEAP_VALIDATE | HEAP_TAIL_CHECKING_ENABLED |
+                                              HEAP_FREE_CHECKING_ENABLED))) return;
+
+    TRACE( "enabling LFH for process heap %p\n", heap );
+    heap->extended_type = HEAP_LFH;
+}
+
+
 /***********************************************************************
  *           RtlAllocateHeap   (NTDLL.@)
  *
@@ -1660,13 +1729,14 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
         if (!(status = HEAP_lfh_allocate( heap, flags, size, &ptr ))) break;
         /* fallthrough */
     default:
-        if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
+        if (!(flags & HEAP_NO_SERIALIZE)) enter_alloc_critical_section( heapPtr );
         status = HEAP_std_allocate( heap, flags, size, &ptr );
         if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
         break;
     }
 
     TRACE("(%p,%08x,%08lx), status %#x, ptr %p\n", heapPtr, flags, size, status, ptr );
+    if (!status && TRACE_ON(heapstats)) heap_stats_alloc( heapPtr, size, ptr );
     if (!status) return ptr;
     if ((flags & HEAP_GENERATE_EXCEPTIONS) && status == STATUS_NO_MEMORY) RtlRaiseStatus( status );
     RtlSetLastWin32ErrorAndNtStatusFromNtStatus( status );
@@ -1737,6 +1807,7 @@ NTSTATUS HEAP_std_allocate( HANDLE heap, ULONG flags, SIZE_T size, void **out )
  */
 BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *ptr )
 {
+    SIZE_T size = 0;
     NTSTATUS status;
     HEAP *heapPtr;
 
@@ -1752,6 +1823,7 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
     }
 
     flags &= HEAP_NO_SERIALIZE;
+    if (TRACE_ON(heapstats)) size = RtlSizeHeap( heap, flags, ptr );
     flags |= heapPtr->flags;
 
     switch (heapPtr->extended_type)
@@ -1767,6 +1839,7 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
     }
 
     TRACE("(%p,%08x,%p), status %#x\n", heapPtr, flags, ptr, status );
+    if (!status && size != ~(SIZE_T)0 && TRACE_ON(heapstats)) heap_stats_free( heapPtr, size );
     if (!status) return TRUE;
     RtlSetLastWin32ErrorAndNtStatusFromNtStatus( status );
     return FALSE;
@@ -1811,6 +1884,7 @@ NTSTATUS HEAP_std_free( HANDLE heap, ULONG flags, void *ptr )
  */
 PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size )
 {
+    SIZE_T old_size = 0;
     NTSTATUS status;
     HEAP *heapPtr;
     void *ret;
@@ -1826,6 +1900,7 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
 
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY |
              HEAP_REALLOC_IN_PLACE_ONLY;
+    if (TRACE_ON(heapstats)) old_size = RtlSizeHeap( heap, flags & HEAP_NO_SERIALIZE, ptr );
     flags |= heapPtr->flags;
 
     switch (heapPtr->extended_type)
@@ -1841,6 +1916,11 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     }
 
     TRACE("(%p,%08x,%p,%08lx): returning %p, status %#x\n", heapPtr, flags, ptr, size, ret, status );
+    if (!status && old_size != ~(SIZE_T)0 && TRACE_ON(heapstats))
+    {
+        heap_stats_free( heapPtr, old_size );
+        heap_stats_alloc( heapPtr, size, ret );
+    }
     if (!status) return ret;
     if ((flags & HEAP_GENERATE_EXCEPTIONS) && (status == STATUS_NO_MEMORY)) RtlRaiseStatus( status );
     RtlSetLastWin32ErrorAndNtStatusFromNtStatus( status );
@@ -2349,5 +2429,19 @@ NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_
 
 void HEAP_notify_thread_destroy( BOOLEAN last )
 {
+    if (TRACE_ON(heapstats))
+    {
+        HEAP *heap;
+
+        HEAP_lfh_dump_stats();
+        if (last)
+        {
+            RtlEnterCriticalSection( &processHeap->critSection );
+            heap_dump_stats( processHeap );
+            LIST_FOR_EACH_ENTRY( heap, &processHeap->entry, HEAP, entry ) heap_dump_stats( heap );
+            RtlLeaveCriticalSection( &processHeap->critSection );
+        }
+    }
+
     HEAP_lfh_notify_thread_destroy( last );
 }
@@ -27,6 +27,7 @@
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
+WINE_DECLARE_DEBUG_CHANNEL(heapstats);
 
 typedef struct LFH_ptr LFH_ptr;
 typedef struct LFH_block LFH_block;
@@ -151,10 +152,11 @@ struct LFH_heap
     LFH_class large_class[TOTAL_LARGE_CLASS_COUNT];
 
     SLIST_ENTRY entry_orphan;
+    unsigned int block_used[TOTAL_BLOCK_CLASS_COUNT]; /* used blocks per block class */
 #ifdef _WIN64
-    void *pad[0xc2];
+    void *pad[0x83];
 #else
-    void *pad[0xc3];
+    void *pad[0x46];
 #endif
 };
 
@@ -505,6 +507,8 @@ static inline LFH_block *LFH_allocate_block(LFH_heap *heap, LFH_class *class, LF
     LFH_block *block = LFH_arena_pop_block(arena);
     if (LFH_arena_is_empty(arena))
         LFH_class_pop_arena(class);
+    if (LFH_class_is_block(heap, class))
+        heap->block_used[class - heap->block_class]++;
     return block;
 }
 
@@ -512,6 +516,9 @@ static inline BOOLEAN LFH_deallocate_block(LFH_heap *heap, LFH_arena *arena, LFH
 {
     LFH_class *class = LFH_class_from_arena(arena);
 
+    if (LFH_class_is_block(heap, class))
+        heap->block_used[class - heap->block_class]--;
+
     arena = LFH_parent_from_arena(arena);
     if (LFH_arena_is_empty(arena))
         LFH_class_push_arena(class, arena);
@@ -535,6 +542,7 @@ static void LFH_heap_initialize(LFH_heap *heap)
 
     heap->list_defer = NULL;
     heap->cached_large_arena = NULL;
+    memset(heap->block_used, 0, sizeof(heap->block_used));
 }
 
 static SLIST_HEADER *LFH_orphan_list(void)
@@ -1122,6 +1130,23 @@ void HEAP_lfh_notify_thread_destroy(BOOLEAN last)
         RtlInterlockedPushEntrySList(list_orphan, &heap->entry_orphan);
 }
 
+void HEAP_lfh_dump_stats(void)
+{
+    LFH_heap *heap = LFH_thread_heap(FALSE);
+    size_t i;
+
+    if (!heap) return;
+
+    LFH_deallocate_deferred_blocks(heap);
+
+    TRACE_(heapstats)("thread %04x LFH heap %p\n", GetCurrentThreadId(), heap);
+    for (i = 0; i < TOTAL_BLOCK_CLASS_COUNT; ++i)
+    {
+        if (!heap->block_used[i]) continue;
+        TRACE_(heapstats)("  block class size %Ix: %u used blocks\n", heap->block_class[i].size, heap->block_used[i]);
+    }
+}
+
 void HEAP_lfh_set_debug_flags(ULONG flags)
 {
     LFH_heap *heap = LFH_thread_heap(FALSE);
@@ -134,8 +134,16 @@ typedef struct _wine_modref
     struct file_id        id;
     ULONG                 CheckSum;
     BOOL                  system;
+    LIST_ENTRY            fullname_links;  /* entry in the full name hash table */
+    LIST_ENTRY            fileid_links;    /* entry in the file id hash table */
 } WINE_MODREF;
 
+/* hash tables indexing the modules of the load order list */
+#define MODULE_HASH_SIZE 64
+static LIST_ENTRY basename_hash_table[MODULE_HASH_SIZE];  /* linked through ldr.HashLinks */
+static LIST_ENTRY fullname_hash_table[MODULE_HASH_SIZE];
+static LIST_ENTRY fileid_hash_table[MODULE_HASH_SIZE];
+
 static UINT tls_module_count;      /* number of modules with TLS directory */
 static IMAGE_TLS_DIRECTORY *tls_dirs;  /* array of TLS directories */
 LIST_ENTRY tls_links = { &tls_links, &tls_links };
@@ -526,6 +534,92 @@ static WINE_MODREF *get_modref( HMODULE hmod )
 }
 
 
+/**********************************************************************
+ *	    hash_module_name
+ */
+static ULONG hash_module_name( const UNICODE_STRING *name )
+{
+    ULONG hash = 0;
+
+    RtlHashUnicodeString( name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash );
+    return hash;
+}
+
+
+/**********************************************************************
+ *	    hash_file_id
+ */
+static ULONG hash_file_id( const struct file_id *id )
+{
+    ULONG hash = 0;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(id->ObjectId); i++) hash = hash * 65599 + id->ObjectId[i];
+    return hash;
+}
+
+
+/**********************************************************************
+ *	    init_module_hash_tables
+ */
+static void init_module_hash_tables(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < MODULE_HASH_SIZE; i++)
+    {
+        InitializeListHead( &basename_hash_table[i] );
+        InitializeListHead( &fullname_hash_table[i] );
+        InitializeListHead( &fileid_hash_table[i] );
+    }
+}
+
+
+/**********************************************************************
+ *	    insert_module_names_hash
+ *
+ * Add a module to the name hash tables, in load order.
+ * The loader_section must be locked while calling this function
+ */
+static void insert_module_names_hash( WINE_MODREF *wm )
+{
+    wm->ldr.BaseNameHashValue = hash_module_name( &wm->ldr.BaseDllName );
+    InsertTailList( &basename_hash_table[wm->ldr.BaseNameHashValue % MODULE_HASH_SIZE], &wm->ldr.HashLinks );
+    InsertTailList( &fullname_hash_table[hash_module_name( &wm->ldr.FullDllName ) % MODULE_HASH_SIZE],
+                    &wm->fullname_links );
+    InitializeListHead( &wm->fileid_links );
+}
+
+
+/**********************************************************************
+ *	    insert_module_fileid_hash
+ *
+ * Add a module to the file id hash table once its file id is known.
+ * The loader_section must be locked while calling this function
+ */
+static void insert_module_fileid_hash( WINE_MODREF *wm )
+{
+    InsertTailList( &fileid_hash_table[hash_file_id( &wm->id ) % MODULE_HASH_SIZE], &wm->fileid_links );
+}
+
+
+/**********************************************************************
+ *	    remove_module_hash
+ *
+ * Remove a module from all the hash tables.
+ * The loader_section must be locked while calling this function
+ */
+static void remove_module_hash( WINE_MODREF *wm )
+{
+    RemoveEntryList( &wm->ldr.HashLinks );
+    RemoveEntryList( &wm->fullname_links );
+    RemoveEntryList( &wm->fileid_links );
+    InitializeListHead( &wm->ldr.HashLinks );
+    InitializeListHead( &wm->fullname_links );
+    InitializeListHead( &wm->fileid_links );
+}
+
+
 /**********************************************************************
  *	    find_basename_module
  *
@@ -536,19 +630,22 @@ static WINE_MODREF *find_basename_module( LPCWSTR name )
 {
     PLIST_ENTRY mark, entry;
     UNICODE_STRING name_str;
+    ULONG hash;
 
     RtlInitUnicodeString( &name_str, name );
 
     if (cached_modref && RtlEqualUnicodeString( &name_str, &cached_modref->ldr.BaseDllName, TRUE ))
         return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    hash = hash_module_name( &name_str );
+    mark = &basename_hash_table[hash % MODULE_HASH_SIZE];
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
-        WINE_MODREF *mod = CONTAINING_RECORD(entry, WINE_MODREF, ldr.InLoadOrderLinks);
+        WINE_MODREF *mod = CONTAINING_RECORD(entry, WINE_MODREF, ldr.HashLinks);
+        if (mod->ldr.BaseNameHashValue != hash) continue;
         if (RtlEqualUnicodeString( &name_str, &mod->ldr.BaseDllName, TRUE ) && !mod->system)
         {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
+            cached_modref = mod;
             return cached_modref;
         }
     }
@@ -574,13 +671,13 @@ static WINE_MODREF *find_fullname_module( const UNICODE_STRING *nt_name )
     if (cached_modref && RtlEqualUnicodeString( &name, &cached_modref->ldr.FullDllName, TRUE ))
         return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    mark = &fullname_hash_table[hash_module_name( &name ) % MODULE_HASH_SIZE];
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
-        LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD(entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
-        if (RtlEqualUnicodeString( &name, &mod->FullDllName, TRUE ))
+        WINE_MODREF *mod = CONTAINING_RECORD(entry, WINE_MODREF, fullname_links);
+        if (RtlEqualUnicodeString( &name, &mod->ldr.FullDllName, TRUE ))
         {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
+            cached_modref = mod;
             return cached_modref;
         }
     }
@@ -600,11 +697,10 @@ static WINE_MODREF *find_fileid_module( const struct file_id *id )
 
     if (cached_modref && !memcmp( &cached_modref->id, id, sizeof(*id) )) return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
+    mark = &fileid_hash_table[hash_file_id( id ) % MODULE_HASH_SIZE];
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
-        LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD( entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks );
-        WINE_MODREF *wm = CONTAINING_RECORD( mod, WINE_MODREF, ldr );
+        WINE_MODREF *wm = CONTAINING_RECORD( entry, WINE_MODREF, fileid_links );
 
         if (!memcmp( &wm->id, id, sizeof(*id) ))
         {
@@ -1397,6 +1493,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
                    &wm->ldr.InLoadOrderLinks);
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList,
                    &wm->ldr.InMemoryOrderLinks);
+    insert_module_names_hash( wm );
     /* wait until init is called for inserting into InInitializationOrderModuleList */
 
     if (!(nt->OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_NX_COMPAT))
@@ -2060,7 +2157,11 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
 
     if (!(wm = alloc_module( *module, nt_name, is_builtin ))) return STATUS_NO_MEMORY;
 
-    if (id) wm->id = *id;
+    if (id)
+    {
+        wm->id = *id;
+        insert_module_fileid_hash( wm );
+    }
     if (image_info->LoaderFlags) wm->ldr.Flags |= LDR_COR_IMAGE;
     if (image_info->u.s.ComPlusILOnly) wm->ldr.Flags |= LDR_COR_ILONLY;
     wm->system = system;
@@ -2100,6 +2201,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderLinks);
             RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+            remove_module_hash( wm );
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -3727,6 +3829,7 @@ static void free_modref( WINE_MODREF *wm )
 
     RemoveEntryList(&wm->ldr.InLoadOrderLinks);
     RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+    remove_module_hash( wm );
     if (wm->ldr.InInitializationOrderLinks.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderLinks);
 
@@ -4123,6 +4226,7 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
 
         get_env_var( L"WINESYSTEMDLLPATH", 0, &system_dll_path );
 
+        init_module_hash_tables();
         wm = build_main_module();
         wm->ldr.LoadCount = -1;
 
@@ -136,6 +136,7 @@ NTSTATUS HEAP_lfh_validate( HANDLE std_heap, ULONG flags, const void *ptr );
 void HEAP_notify_thread_destroy( BOOLEAN last );
 void HEAP_lfh_notify_thread_destroy( BOOLEAN last );
 void HEAP_lfh_set_debug_flags( ULONG flags );
+void HEAP_lfh_dump_stats(void);
 
 #define HASH_STRING_ALGORITHM_DEFAULT  0
 #define HASH_STRING_ALGORITHM_X65599   1
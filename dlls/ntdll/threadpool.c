@@ -30,6 +30,7 @@
 
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/rbtree.h"
 
 #include "ntdll_misc.h"
 
@@ -72,13 +73,14 @@ struct timer_queue;
 struct queue_timer
 {
     struct timer_queue *q;
-    struct list entry;
+    struct wine_rb_entry entry;
     ULONG runcount;             /* number of callbacks pending execution */
     RTL_WAITORTIMERCALLBACKFUNC callback;
     PVOID param;
     DWORD period;
     ULONG flags;
     ULONGLONG expire;
+    ULONGLONG seq;              /* insertion order, to keep timers with the same expiration FIFO */
     BOOL destroy;               /* timer should be deleted; once set, never unset */
     HANDLE event;               /* removal event */
 };
@@ -87,7 +89,8 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct wine_rb_tree timers; /* sorted by expiration time */
+    ULONGLONG timer_seq;        /* sequence number of the next inserted timer */
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -98,6 +101,7 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
+#define THREADPOOL_SPIN_COUNT     4000
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
 /* internal threadpool representation */
@@ -178,9 +182,10 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct wine_rb_entry timer_entry;
             BOOL            timer_set;
             ULONGLONG       timeout;
+            ULONGLONG       seq;
             LONG            period;
             LONG            window_length;
         } timer;
@@ -238,13 +243,15 @@ struct threadpool_group
 
 /* global timerqueue object */
 static RTL_CRITICAL_SECTION_DEBUG timerqueue_debug;
+static int compare_timer_timeout( const void *key, const struct wine_rb_entry *entry );
 
 static struct
 {
     CRITICAL_SECTION        cs;
     LONG                    objcount;
     BOOL                    thread_running;
-    struct list             pending_timers;
+    struct wine_rb_tree     pending_timers;
+    ULONGLONG               timer_seq;
     RTL_CONDITION_VARIABLE  update_event;
 }
 timerqueue =
@@ -252,7 +259,8 @@ timerqueue =
     { &timerqueue_debug, -1, 0, 0, 0, 0 },      /* cs */
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
-    LIST_INIT( timerqueue.pending_timers ),     /* pending_timers */
+    { compare_timer_timeout, NULL },            /* pending_timers */
+    0,                                          /* timer_seq */
     RTL_CONDITION_VARIABLE_INIT                 /* update_event */
 };
 
@@ -367,6 +375,7 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled );
 static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread );
 static void tp_object_prepare_shutdown( struct threadpool_object *object );
 static BOOL tp_object_release( struct threadpool_object *object );
+static BOOL tp_threadpool_release( struct threadpool *pool );
 static struct threadpool *default_threadpool = NULL;
 
 static BOOL array_reserve(void **elements, unsigned int *capacity, unsigned int count, unsigned int size)
@@ -549,6 +558,22 @@ static inline PLARGE_INTEGER get_nt_timeout( PLARGE_INTEGER pTime, ULONG timeout
 
 /************************** Timer Queue Impl **************************/
 
+static int compare_queue_timer(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct queue_timer *a = key;
+    const struct queue_timer *b = WINE_RB_ENTRY_VALUE(entry, const struct queue_timer, entry);
+
+    if (a->expire != b->expire) return a->expire < b->expire ? -1 : 1;
+    if (a->seq != b->seq) return a->seq < b->seq ? -1 : 1;
+    return 0;
+}
+
+static inline struct queue_timer *queue_first_timer(struct timer_queue *q)
+{
+    struct wine_rb_entry *ptr = wine_rb_head(q->timers.root);
+    return ptr ? WINE_RB_ENTRY_VALUE(ptr, struct queue_timer, entry) : NULL;
+}
+
 static void queue_remove_timer(struct queue_timer *t)
 {
     /* We MUST hold the queue cs while calling this function.  This ensures
@@ -559,12 +584,12 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->runcount == 0);
     assert(t->destroy);
 
-    list_remove(&t->entry);
+    wine_rb_remove(&q->timers, &t->entry);
     if (t->event)
         NtSetEvent(t->event, NULL);
     RtlFreeHeap(GetProcessHeap(), 0, t);
 
-    if (q->quit && list_empty(&q->timers))
+    if (q->quit && !q->timers.root)
         NtSetEvent(q->event, NULL);
 }
 
@@ -602,24 +627,16 @@ static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
 {
     /* We MUST hold the queue cs while calling this function.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
     t->expire = time;
+    t->seq = q->timer_seq++;
+    wine_rb_put(&q->timers, t, &t->entry);
 
-    /* If we insert at the head of the list, we need to expire sooner
+    /* If we insert at the head of the queue, we need to expire sooner
        than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    if (set_event && queue_first_timer(q) == t)
         NtSetEvent(q->event, NULL);
 }
 
@@ -627,7 +644,7 @@ static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
                                     BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
+    wine_rb_remove(&t->q->timers, &t->entry);
     queue_add_timer(t, time, set_event);
 }
 
@@ -636,10 +653,9 @@ static void queue_timer_expire(struct timer_queue *q)
     struct queue_timer *t = NULL;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((t = queue_first_timer(q)))
     {
         ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
         if (!t->destroy && t->expire <= ((now = queue_current_time())))
         {
             ++t->runcount;
@@ -682,9 +698,8 @@ static ULONG queue_get_timeout(struct timer_queue *q)
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((t = queue_first_timer(q)))
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
         assert(!t->destroy || t->expire == EXPIRE_NEVER);
 
         if (t->expire != EXPIRE_NEVER)
@@ -720,7 +735,7 @@ static void WINAPI timer_queue_thread_proc(LPVOID p)
                timer got put at the head of the list so we need to adjust
                our timeout.  */
             RtlEnterCriticalSection(&q->cs);
-            if (q->quit && list_empty(&q->timers))
+            if (q->quit && !q->timers.root)
                 done = TRUE;
             RtlLeaveCriticalSection(&q->cs);
         }
@@ -775,7 +790,8 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
         return STATUS_NO_MEMORY;
 
     RtlInitializeCriticalSection(&q->cs);
-    list_init(&q->timers);
+    wine_rb_init(&q->timers, compare_queue_timer);
+    q->timer_seq = 0;
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -816,7 +832,7 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 NTSTATUS WINAPI RtlDeleteTimerQueueEx(HANDLE TimerQueue, HANDLE CompletionEvent)
 {
     struct timer_queue *q = TimerQueue;
-    struct queue_timer *t, *temp;
+    struct wine_rb_entry *ptr, *next;
     HANDLE thread;
     NTSTATUS status;
 
@@ -827,11 +843,14 @@ NTSTATUS WINAPI RtlDeleteTimerQueueEx(HANDLE TimerQueue, HANDLE CompletionEvent)
 
     RtlEnterCriticalSection(&q->cs);
     q->quit = TRUE;
-    if (list_head(&q->timers))
+    if (q->timers.root)
         /* When the last timer is removed, it will signal the timer thread to
            exit...  */
-        LIST_FOR_EACH_ENTRY_SAFE(t, temp, &q->timers, struct queue_timer, entry)
-            queue_destroy_timer(t);
+        for (ptr = wine_rb_head(q->timers.root); ptr; ptr = next)
+        {
+            next = wine_rb_next(ptr);
+            queue_destroy_timer(WINE_RB_ENTRY_VALUE(ptr, struct queue_timer, entry));
+        }
     else
         /* However if we have none, we must do it ourselves.  */
         NtSetEvent(q->event, NULL);
@@ -1041,6 +1060,16 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+static int compare_timer_timeout( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct threadpool_object *a = key;
+    const struct threadpool_object *b = WINE_RB_ENTRY_VALUE( entry, const struct threadpool_object, u.timer.timer_entry );
+
+    if (a->u.timer.timeout != b->u.timer.timeout) return a->u.timer.timeout < b->u.timer.timeout ? -1 : 1;
+    if (a->u.timer.seq != b->u.timer.seq) return a->u.timer.seq < b->u.timer.seq ? -1 : 1;
+    return 0;
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
@@ -1049,7 +1078,7 @@ static void CALLBACK timerqueue_thread_proc( void *param )
     ULONGLONG timeout_lower, timeout_upper, new_timeout;
     struct threadpool_object *other_timer;
     LARGE_INTEGER now, timeout;
-    struct list *ptr;
+    struct wine_rb_entry *ptr;
 
     TRACE( "starting timer queue thread\n" );
 
@@ -1059,16 +1088,16 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         NtQuerySystemTime( &now );
 
         /* Check for expired timers. */
-        while ((ptr = list_head( &timerqueue.pending_timers )))
+        while ((ptr = wine_rb_head( timerqueue.pending_timers.root )))
         {
-            struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+            struct threadpool_object *timer = WINE_RB_ENTRY_VALUE( ptr, struct threadpool_object, u.timer.timer_entry );
             assert( timer->type == TP_OBJECT_TYPE_TIMER );
             assert( timer->u.timer.timer_pending );
             if (timer->u.timer.timeout > now.QuadPart)
                 break;
 
             /* Queue a new callback in one of the worker threads. */
-            list_remove( &timer->u.timer.timer_entry );
+            wine_rb_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
             tp_object_submit( timer, FALSE );
 
@@ -1079,14 +1108,8 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
+                timer->u.timer.seq = timerqueue.timer_seq++;
+                wine_rb_put( &timerqueue.pending_timers, timer, &timer->u.timer.timer_entry );
                 timer->u.timer.timer_pending = TRUE;
             }
         }
@@ -1094,8 +1117,8 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         timeout_lower = timeout_upper = MAXLONGLONG;
 
         /* Determine next timeout and use the window length to optimize wakeup times. */
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
+        WINE_RB_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
+                                struct threadpool_object, u.timer.timer_entry )
         {
             assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
             if (other_timer->u.timer.timeout >= timeout_upper)
@@ -1153,6 +1176,50 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
     return status;
 }
 
+/***********************************************************************
+ *           tp_start_worker_thread    (internal)
+ *
+ * Start a worker thread which was already accounted for with pool->cs
+ * held, so that the lock isn't held while the thread is created.
+ */
+static void tp_start_worker_thread( struct threadpool *pool )
+{
+    LARGE_INTEGER timeout;
+    HANDLE thread;
+    NTSTATUS status;
+    int retries = 0;
+
+    for (;;)
+    {
+        status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, 0, 0, 0,
+                                      threadpool_worker_proc, pool, &thread, NULL );
+        if (status == STATUS_SUCCESS)
+        {
+            NtClose( thread );
+            return;
+        }
+
+        /* Let an existing thread process the work item instead. If this was
+         * the only worker, nothing else would pick it up, so try again. */
+        RtlEnterCriticalSection( &pool->cs );
+        if (pool->num_workers > 1 || ++retries > 10)
+        {
+            if (pool->num_workers == 1)
+                ERR( "failed to start a worker thread for pool %p, status %#x\n", pool, status );
+            pool->num_workers--;
+            RtlWakeConditionVariable( &pool->update_event );
+            RtlLeaveCriticalSection( &pool->cs );
+            tp_threadpool_release( pool );
+            return;
+        }
+        RtlLeaveCriticalSection( &pool->cs );
+
+        WARN( "failed to start a worker thread for pool %p, status %#x, retrying\n", pool, status );
+        timeout.QuadPart = (ULONGLONG)retries * -100000;
+        NtDelayExecution( FALSE, &timeout );
+    }
+}
+
 /***********************************************************************
  *           tp_timerqueue_lock    (internal)
  *
@@ -1211,14 +1278,14 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
         {
-            list_remove( &timer->u.timer.timer_entry );
+            wine_rb_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
         }
 
         /* If the last timer object was destroyed, then wake up the thread. */
         if (!--timerqueue.objcount)
         {
-            assert( list_empty( &timerqueue.pending_timers ) );
+            assert( !timerqueue.pending_timers.root );
             RtlWakeAllConditionVariable( &timerqueue.update_event );
         }
 
@@ -1663,7 +1730,8 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     pool->objcount              = 0;
     pool->shutdown              = FALSE;
 
-    RtlInitializeCriticalSection( &pool->cs );
+    /* the lock is only held for short periods, spin before blocking on it */
+    RtlInitializeCriticalSectionEx( &pool->cs, THREADPOOL_SPIN_COUNT, 0 );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
     for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
@@ -1970,17 +2038,22 @@ static void tp_object_prio_queue( struct threadpool_object *object )
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
+    BOOL new_worker = FALSE;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
     RtlEnterCriticalSection( &pool->cs );
 
-    /* Start new worker threads if required. */
+    /* Account for a new worker thread if required, it is started once
+     * the lock has been released. */
     if (pool->num_busy_workers >= pool->num_workers &&
         pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    {
+        InterlockedIncrement( &pool->refcount );
+        pool->num_workers++;
+        new_worker = TRUE;
+    }
 
     /* Queue work item and increment refcount. */
     InterlockedIncrement( &object->refcount );
@@ -1992,13 +2065,15 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
         object->u.wait.signaled++;
 
     /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
+    if (!new_worker)
     {
         assert( pool->num_workers > 0 );
         RtlWakeConditionVariable( &pool->update_event );
     }
 
     RtlLeaveCriticalSection( &pool->cs );
+
+    if (new_worker) tp_start_worker_thread( pool );
 }
 
 /***********************************************************************
@@ -2956,7 +3031,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2995,7 +3069,7 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
     {
-        list_remove( &this->u.timer.timer_entry );
+        wine_rb_remove( &timerqueue.pending_timers, &this->u.timer.timer_entry );
         this->u.timer.timer_pending = FALSE;
     }
 
@@ -3006,17 +3080,11 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
+        this->u.timer.seq = timerqueue.timer_seq++;
+        wine_rb_put( &timerqueue.pending_timers, this, &this->u.timer.timer_entry );
 
         /* Wake up the timer thread when the timeout has to be updated. */
-        if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
+        if (wine_rb_head( timerqueue.pending_timers.root ) == &this->u.timer.timer_entry)
             RtlWakeAllConditionVariable( &timerqueue.update_event );
 
         this->u.timer.timer_pending = TRUE;
@@ -220,6 +220,30 @@ static const unsigned int dir_data_names_initial_size  = 64;
 static struct dir_data **dir_data_cache;
 static unsigned int dir_data_cache_size;
 
+/* case-insensitive index of the names of a directory, used to resolve path components */
+struct dir_lookup_slot
+{
+    unsigned int            hash;    /* hash of the upper-case name */
+    unsigned int            entry;   /* (index in the names array << 1 | is_short_name) + 1, 0 if free */
+};
+
+struct dir_lookup
+{
+    struct list             entry;     /* entry in the lookup cache, most recently used first */
+    struct dir_data        *data;      /* directory file names */
+    LARGE_INTEGER           mtime;     /* directory modification time when it was read */
+    LARGE_INTEGER           ctime;     /* directory change time when it was read */
+    LARGE_INTEGER           read_time; /* time the directory was read */
+    unsigned int            hash_size; /* size of the hash table, a power of 2 */
+    struct dir_lookup_slot *hash;      /* hash table of the long and short names */
+};
+
+#define MAX_DIR_LOOKUP_CACHE 32
+
+static struct list dir_lookup_cache = LIST_INIT( dir_lookup_cache );
+static unsigned int dir_lookup_cache_count;
+static unsigned int dir_lookup_hits, dir_lookup_misses, dir_lookup_stale;
+
 static BOOL show_dot_files;
 static mode_t start_umask;
 
@@ -227,6 +251,7 @@ static mode_t start_umask;
 static const BOOL is_case_sensitive = FALSE;
 
 static pthread_mutex_t dir_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t dir_lookup_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t mnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* check if a given Unicode char is OK in a DOS short name */
@@ -2473,6 +2498,200 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 }
 
 
+static unsigned int hash_dir_lookup_name( const WCHAR *name, int length )
+{
+    unsigned int hash = 0;
+    while (length--) hash = hash * 31 + towupper( *name++ );
+    return hash;
+}
+
+static void add_dir_lookup_name( struct dir_lookup *lookup, const WCHAR *name, unsigned int entry )
+{
+    unsigned int hash = hash_dir_lookup_name( name, wcslen( name ));
+    unsigned int i = hash & (lookup->hash_size - 1);
+
+    while (lookup->hash[i].entry) i = (i + 1) & (lookup->hash_size - 1);
+    lookup->hash[i].hash = hash;
+    lookup->hash[i].entry = entry;
+}
+
+static void free_dir_lookup( struct dir_lookup *lookup )
+{
+    free_dir_data( lookup->data );
+    free( lookup->hash );
+    free( lookup );
+}
+
+/* read a directory and build the case-insensitive index of its names */
+static struct dir_lookup *read_dir_lookup( const char *unix_name, const struct stat *st )
+{
+    struct dir_lookup *lookup;
+    struct dirent *de;
+    LARGE_INTEGER atime, creation;
+    unsigned int i;
+    DIR *dir;
+
+    if (!(dir = opendir( unix_name ))) return NULL;
+    if (!(lookup = calloc( 1, sizeof(*lookup) ))) goto failed;
+    if (!(lookup->data = calloc( 1, sizeof(*lookup->data) ))) goto failed;
+    lookup->data->id.dev = st->st_dev;
+    lookup->data->id.ino = st->st_ino;
+    get_file_times( st, &lookup->mtime, &lookup->ctime, &atime, &creation );
+    NtQuerySystemTime( &lookup->read_time );
+
+    while ((de = readdir( dir )))
+        if (!append_entry( lookup->data, de->d_name, NULL, NULL )) goto failed;
+    closedir( dir );
+    dir = NULL;
+
+    /* keep the table at most half full, counting both long and short names */
+    lookup->hash_size = 16;
+    while (lookup->hash_size < lookup->data->count * 4) lookup->hash_size *= 2;
+    if (!(lookup->hash = calloc( lookup->hash_size, sizeof(*lookup->hash) ))) goto failed;
+    for (i = 0; i < lookup->data->count; i++)
+    {
+        add_dir_lookup_name( lookup, lookup->data->names[i].long_name, (i << 1) + 1 );
+        if (lookup->data->names[i].short_name[0])
+            add_dir_lookup_name( lookup, lookup->data->names[i].short_name, (i << 1 | 1) + 1 );
+    }
+    return lookup;
+
+failed:
+    if (dir) closedir( dir );
+    if (lookup) free_dir_lookup( lookup );
+    return NULL;
+}
+
+/***********************************************************************
+ *           get_cached_dir_lookup
+ *
+ * Get the cached name index of a directory, discarding it if the directory has changed.
+ * The directory times are only trusted once they are old enough to be distinguishable
+ * from a later change. Caller must hold dir_lookup_mutex.
+ */
+static struct dir_lookup *get_cached_dir_lookup( const struct stat *st )
+{
+    struct dir_lookup *lookup;
+    LARGE_INTEGER mtime, ctime, atime, creation;
+
+    get_file_times( st, &mtime, &ctime, &atime, &creation );
+
+    LIST_FOR_EACH_ENTRY( lookup, &dir_lookup_cache, struct dir_lookup, entry )
+    {
+        if (lookup->data->id.dev != st->st_dev || lookup->data->id.ino != st->st_ino) continue;
+        list_remove( &lookup->entry );
+        if (lookup->mtime.QuadPart == mtime.QuadPart && lookup->ctime.QuadPart == ctime.QuadPart &&
+            lookup->mtime.QuadPart + 2 * TICKSPERSEC <= lookup->read_time.QuadPart &&
+            lookup->ctime.QuadPart + 2 * TICKSPERSEC <= lookup->read_time.QuadPart)
+        {
+            list_add_head( &dir_lookup_cache, &lookup->entry );
+            dir_lookup_hits++;
+            return lookup;
+        }
+        free_dir_lookup( lookup );
+        dir_lookup_cache_count--;
+        dir_lookup_stale++;
+        break;
+    }
+
+    dir_lookup_misses++;
+    return NULL;
+}
+
+/***********************************************************************
+ *           add_cached_dir_lookup
+ *
+ * Add a freshly read directory index to the cache, replacing the one another
+ * thread may have added in the meantime. Caller must hold dir_lookup_mutex.
+ */
+static void add_cached_dir_lookup( struct dir_lookup *new_lookup )
+{
+    struct dir_lookup *lookup;
+
+    LIST_FOR_EACH_ENTRY( lookup, &dir_lookup_cache, struct dir_lookup, entry )
+    {
+        if (lookup->data->id.dev != new_lookup->data->id.dev ||
+            lookup->data->id.ino != new_lookup->data->id.ino) continue;
+        list_remove( &lookup->entry );
+        free_dir_lookup( lookup );
+        dir_lookup_cache_count--;
+        break;
+    }
+
+    list_add_head( &dir_lookup_cache, &new_lookup->entry );
+    if (++dir_lookup_cache_count > MAX_DIR_LOOKUP_CACHE)
+    {
+        struct dir_lookup *last = LIST_ENTRY( list_tail( &dir_lookup_cache ), struct dir_lookup, entry );
+        list_remove( &last->entry );
+        free_dir_lookup( last );
+        dir_lookup_cache_count--;
+    }
+}
+
+/* find a name in a directory index, appending the first match in directory order to unix_name at pos */
+static BOOL find_dir_lookup_name( const struct dir_lookup *lookup, char *unix_name, int pos,
+                                  const WCHAR *name, int length, BOOLEAN short_names )
+{
+    unsigned int hash = hash_dir_lookup_name( name, length );
+    unsigned int i, index, best = lookup->data->count;
+    const struct dir_lookup_slot *slot;
+    const WCHAR *str;
+
+    for (i = hash & (lookup->hash_size - 1); (slot = &lookup->hash[i])->entry; i = (i + 1) & (lookup->hash_size - 1))
+    {
+        if (slot->hash != hash) continue;
+        index = (slot->entry - 1) >> 1;
+        if (index >= best) continue;
+        if ((slot->entry - 1) & 1)
+        {
+            if (!short_names) continue;
+            str = lookup->data->names[index].short_name;
+        }
+        else str = lookup->data->names[index].long_name;
+        if (wcslen( str ) == length && !wcsnicmp( str, name, length )) best = index;
+    }
+    if (best == lookup->data->count) return FALSE;
+    unix_name[pos - 1] = '/';
+    strcpy( unix_name + pos, lookup->data->names[best].unix_name );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           lookup_dir_name
+ *
+ * Find a name through the cached index of a directory, reading the directory again
+ * if it has changed. The directory is read without holding dir_lookup_mutex, which
+ * only protects the cache itself. The file found is appended to unix_name at pos.
+ * Returns 1 if found, 0 if not found, -1 if the directory index is not available.
+ */
+static int lookup_dir_name( char *unix_name, int pos, const WCHAR *name, int length,
+                            BOOLEAN short_names )
+{
+    struct dir_lookup *lookup;
+    struct stat st;
+    int ret = 0;
+
+    if (stat( unix_name, &st ) == -1) return -1;
+
+    mutex_lock( &dir_lookup_mutex );
+    if ((lookup = get_cached_dir_lookup( &st )))
+        ret = find_dir_lookup_name( lookup, unix_name, pos, name, length, short_names );
+    else
+        TRACE( "reading %s, %u hits %u misses %u stale\n", debugstr_a(unix_name),
+               dir_lookup_hits, dir_lookup_misses, dir_lookup_stale );
+    mutex_unlock( &dir_lookup_mutex );
+    if (lookup) return ret;
+
+    if (!(lookup = read_dir_lookup( unix_name, &st ))) return -1;
+
+    mutex_lock( &dir_lookup_mutex );
+    add_cached_dir_lookup( lookup );
+    ret = find_dir_lookup_name( lookup, unix_name, pos, name, length, short_names );
+    mutex_unlock( &dir_lookup_mutex );
+    return ret;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2563,6 +2782,12 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    if ((ret = lookup_dir_name( unix_name, pos, name, length, is_name_8_dot_3 )) > 0)
+        return STATUS_SUCCESS;
+    if (!ret) goto not_found;
+
+    /* fall back to searching the directory directly */
+
     if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
 
     unix_name[pos - 1] = '/';
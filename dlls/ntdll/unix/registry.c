@@ -39,6 +39,36 @@ WINE_DEFAULT_DEBUG_CHANNEL(reg);
 /* maximum length of a value name in bytes (without terminating null) */
 #define MAX_VALUE_LENGTH (16383 * sizeof(WCHAR))
 
+/* values of frequently queried keys published by the server in shared memory */
+static volatile struct registry_shared_memory *registry_shared;
+static BOOL registry_shared_failed;
+
+/* cache of the shared memory ids of key handles, as (handle << 32) | key_id */
+#define SHARED_KEY_CACHE_SIZE 256
+static LONG64 shared_key_cache[SHARED_KEY_CACHE_SIZE];
+static LONG shared_key_cache_serial;  /* incremented when a handle is closed */
+static unsigned int shared_key_cache_close_serial;  /* close_serial of the shared memory for the cache contents */
+
+#if defined(__i386__) || defined(__x86_64__)
+#define __SHARED_READ_SEQ( x ) (*(x))
+#define __SHARED_READ_FENCE do {} while(0)
+#else
+#define __SHARED_READ_SEQ( x ) __atomic_load_n( x, __ATOMIC_RELAXED )
+#define __SHARED_READ_FENCE __atomic_thread_fence( __ATOMIC_ACQUIRE )
+#endif
+
+#define SHARED_READ_BEGIN( x )                                          \
+    do {                                                                \
+        unsigned int __seq;                                             \
+        do {                                                            \
+            while ((__seq = __SHARED_READ_SEQ( x )) & SEQUENCE_MASK) NtYieldExecution(); \
+            __SHARED_READ_FENCE;
+
+#define SHARED_READ_END( x )                       \
+            __SHARED_READ_FENCE;                   \
+        } while (__SHARED_READ_SEQ( x ) != __seq); \
+    } while(0)
+
 
 NTSTATUS open_hkcu_key( const char *path, HANDLE *key )
 {
@@ -451,6 +481,162 @@ NTSTATUS WINAPI NtEnumerateValueKey( HANDLE handle, ULONG index, KEY_VALUE_INFOR
 }
 
 
+/* map the registry shared memory on first use */
+static volatile struct registry_shared_memory *get_registry_shared_memory(void)
+{
+    static const WCHAR nameW[] = {'\\','K','e','r','n','e','l','O','b','j','e','c','t','s','\\',
+        '_','_','w','i','n','e','_','r','e','g','i','s','t','r','y','_','s','h','a','r','e','d','_','d','a','t','a',0};
+    UNICODE_STRING name;
+    OBJECT_ATTRIBUTES attr;
+    HANDLE handle;
+    void *ptr = NULL;
+    SIZE_T size = 0;
+    NTSTATUS status;
+
+    if (registry_shared || registry_shared_failed) return registry_shared;
+
+    init_unicode_string( &name, nameW );
+    InitializeObjectAttributes( &attr, &name, 0, 0, NULL );
+    if (!(status = NtOpenSection( &handle, SECTION_MAP_READ, &attr )))
+    {
+        status = NtMapViewOfSection( handle, NtCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                     ViewShare, 0, PAGE_READONLY );
+        NtClose( handle );
+    }
+    if (status)
+    {
+        WARN( "failed to map registry shared memory, status %#x\n", status );
+        registry_shared_failed = TRUE;
+        return NULL;
+    }
+    if (InterlockedCompareExchangePointer( (void **)&registry_shared, ptr, NULL ))
+        NtUnmapViewOfSection( NtCurrentProcess(), ptr );
+    return registry_shared;
+}
+
+static inline LONG64 *get_shared_key_cache_entry( HANDLE handle )
+{
+    return &shared_key_cache[(HandleToULong( handle ) >> 2) % SHARED_KEY_CACHE_SIZE];
+}
+
+/* retrieve the shared memory id of a key handle, 0 if unknown */
+static unsigned int get_shared_key_id( HANDLE handle )
+{
+    unsigned int i, close_serial;
+    LONG64 entry, prev;
+    sigset_t sigset;
+
+    if (!registry_shared) return 0;
+
+    /* another process closed one of our key handles, the cached handle values may have been reused */
+    if ((close_serial = registry_shared->close_serial) != shared_key_cache_close_serial)
+    {
+        server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+        for (i = 0; i < SHARED_KEY_CACHE_SIZE; i++)
+        {
+            entry = shared_key_cache[i];
+            while ((prev = InterlockedCompareExchange64( &shared_key_cache[i], 0, entry )) != entry) entry = prev;
+        }
+        shared_key_cache_serial++;
+        shared_key_cache_close_serial = close_serial;
+        server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+        return 0;
+    }
+    entry = InterlockedCompareExchange64( get_shared_key_cache_entry( handle ), 0, 0 );
+    if ((ULONG)(entry >> 32) != HandleToULong( handle )) return 0;
+    return (ULONG)entry;
+}
+
+/* store the shared memory id returned by the server for a key handle */
+static void set_shared_key_id( HANDLE handle, unsigned int key_id, LONG serial, unsigned int close_serial )
+{
+    LONG64 *ptr = get_shared_key_cache_entry( handle );
+    LONG64 entry = ((LONG64)HandleToULong( handle ) << 32) | key_id;
+    LONG64 prev;
+    sigset_t sigset;
+
+    if (!key_id)
+    {
+        /* don't clear the entry of a different handle */
+        prev = InterlockedCompareExchange64( ptr, 0, 0 );
+        if ((ULONG)(prev >> 32) == HandleToULong( handle )) InterlockedCompareExchange64( ptr, 0, prev );
+        return;
+    }
+    if (!get_registry_shared_memory()) return;
+
+    /* the handle may have been closed and reused since the server call */
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    if (serial == shared_key_cache_serial && close_serial == shared_key_cache_close_serial)
+    {
+        LONG64 tmp = *ptr;
+        while ((prev = InterlockedCompareExchange64( ptr, entry, tmp )) != tmp) tmp = prev;
+    }
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+}
+
+/***********************************************************************
+ *           remove_key_from_shared_cache
+ *
+ * Forget the shared memory id of a closed handle.
+ * Caller must hold fd_cache_mutex.
+ */
+void remove_key_from_shared_cache( HANDLE handle )
+{
+    LONG64 *ptr = get_shared_key_cache_entry( handle );
+    LONG64 prev = InterlockedCompareExchange64( ptr, 0, 0 );
+
+    shared_key_cache_serial++;
+    if ((ULONG)(prev >> 32) == HandleToULong( handle )) InterlockedCompareExchange64( ptr, 0, prev );
+}
+
+/* look up a value in the shared memory; return FALSE if the key is not published there,
+ * or if the name doesn't match any value exactly, so that the server takes care of the
+ * case-insensitive comparison */
+static BOOL query_shared_value( HANDLE handle, const UNICODE_STRING *name, UCHAR *data, DWORD size,
+                                int *type, data_size_t *total, NTSTATUS *status )
+{
+    volatile struct registry_shared_slot *slot;
+    const volatile struct registry_shared_value *value;
+    unsigned int key_id, i, count, pos, end, namelen, len, value_size;
+    const WCHAR *value_name;
+    BOOL ret;
+
+    if (!(key_id = get_shared_key_id( handle ))) return FALSE;
+    slot = &registry_shared->slots[key_id & (REGISTRY_SHARED_SLOTS - 1)];
+
+    SHARED_READ_BEGIN( &slot->seq );
+    {
+        ret = (slot->key_id == key_id);
+        *type = -1;
+        *total = 0;
+        count = ret ? slot->count : 0;
+        end = min( slot->size, sizeof(slot->data) );
+        /* the data may be modified while we read it, so validate everything */
+        for (i = pos = 0; i < count && pos + sizeof(*value) <= end; i++, pos += value_size)
+        {
+            value = (const volatile struct registry_shared_value *)(slot->data + pos);
+            namelen = value->namelen;
+            len = value->len;
+            if (namelen > end || len > end) break;
+            value_size = (sizeof(*value) + namelen + len + 3) & ~3;
+            if (pos + value_size > end) break;
+            if (namelen != name->Length) continue;
+
+            value_name = (const WCHAR *)(value + 1);
+            if (memcmp( value_name, name->Buffer, namelen )) continue;
+            *type = value->type;
+            *total = len;
+            if (data) memcpy( data, (const char *)value_name + namelen, min( size, len ) );
+            break;
+        }
+    }
+    SHARED_READ_END( &slot->seq );
+
+    if (!ret || *type == -1) return FALSE;
+    *status = STATUS_SUCCESS;
+    return TRUE;
+}
+
 /******************************************************************************
  *              NtQueryValueKey  (NTDLL.@)
  */
@@ -461,6 +647,10 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
     NTSTATUS ret;
     UCHAR *data_ptr;
     unsigned int fixed_size, min_size;
+    data_size_t total;
+    int type;
+    LONG serial;
+    unsigned int close_serial;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, length );
 
@@ -501,21 +691,31 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         return STATUS_INVALID_PARAMETER;
     }
 
-    SERVER_START_REQ( get_key_value )
+    if (!query_shared_value( handle, name, length > fixed_size ? data_ptr : NULL, length - fixed_size,
+                             &type, &total, &ret ))
     {
-        req->hkey = wine_server_obj_handle( handle );
-        wine_server_add_data( req, name->Buffer, name->Length );
-        if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
-        if (!(ret = wine_server_call( req )))
+        serial = shared_key_cache_serial;
+        close_serial = registry_shared ? registry_shared->close_serial : 0;
+        SERVER_START_REQ( get_key_value )
         {
-            copy_key_value_info( info_class, info, length, reply->type,
-                                 name->Length, reply->total );
-            *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
-            if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
-            else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
+            req->hkey = wine_server_obj_handle( handle );
+            wine_server_add_data( req, name->Buffer, name->Length );
+            if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
+            ret = wine_server_call( req );
+            type = reply->type;
+            total = reply->total;
+            set_shared_key_id( handle, reply->shared_id, serial, close_serial );
         }
+        SERVER_END_REQ;
+    }
+
+    if (!ret)
+    {
+        copy_key_value_info( info_class, info, length, type, name->Length, total );
+        *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : total);
+        if (length < min_size) ret = STATUS_BUFFER_TOO_SMALL;
+        else if (length < *result_len) ret = STATUS_BUFFER_OVERFLOW;
     }
-    SERVER_END_REQ;
     return ret;
 }
 
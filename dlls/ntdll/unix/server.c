@@ -1674,7 +1674,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     if (options & DUPLICATE_CLOSE_SOURCE)
+    {
         fd = remove_fd_from_cache( source );
+        remove_key_from_shared_cache( source );
+    }
 
     SERVER_START_REQ( dup_handle )
     {
@@ -1732,6 +1735,7 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     /* always remove the cached fd; if the server request fails we'll just
      * retrieve it again */
     fd = remove_fd_from_cache( handle );
+    remove_key_from_shared_cache( handle );
 
     if (do_fsync())
         fsync_close( handle );
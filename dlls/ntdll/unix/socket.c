@@ -28,6 +28,9 @@
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
 #endif
@@ -148,6 +151,7 @@ struct async_transmit_ioctl
     unsigned int head_len;
     unsigned int tail_len;
     LARGE_INTEGER offset;
+    BOOL no_sendfile;           /* sendfile() is not supported for this file */
 };
 
 static int get_sock_type( HANDLE handle );
@@ -837,6 +841,14 @@ static NTSTATUS try_send( int fd, struct async_send_ioctl *async )
     return STATUS_SUCCESS;
 }
 
+static BOOL is_stream_socket( int fd )
+{
+    int type;
+    socklen_t len = sizeof(type);
+
+    return !getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &len ) && type == SOCK_STREAM;
+}
+
 static BOOL async_send_proc( void *user, ULONG_PTR *info, NTSTATUS *status )
 {
     struct async_send_ioctl *async = user;
@@ -927,6 +939,18 @@ static NTSTATUS sock_send( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc, voi
         return status;
     }
 
+    /* A send which fully completed on a connection-oriented socket doesn't
+     * change any server-side socket state, so unless the server needs to
+     * queue an APC or a completion for us we can skip the round trip. */
+    if (status == STATUS_SUCCESS && event && !apc && !apc_user && is_stream_socket( fd ))
+    {
+        io->Status = STATUS_SUCCESS;
+        io->Information = async->sent_len;
+        release_fileio( &async->io );
+        NtSetEvent( event, NULL );
+        return STATUS_SUCCESS;
+    }
+
     if (status == STATUS_DEVICE_NOT_READY && force_async)
         status = STATUS_PENDING;
 
@@ -985,6 +1009,42 @@ static NTSTATUS try_transmit( int sock_fd, int file_fd, struct async_transmit_io
         async->file_cursor += ret;
     }
 
+#ifdef HAVE_SYS_SENDFILE_H
+    if (async->file && !async->no_sendfile && async->buffer_cursor == async->read_len)
+    {
+        size_t count = async->file_len ? async->file_len - async->file_cursor : 0x7ffff000;
+        off_t offset = async->offset.QuadPart;
+
+        TRACE( "sending %zu bytes of file data with sendfile\n", count );
+        do
+        {
+            if (async->offset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+                ret = sendfile( sock_fd, file_fd, NULL, count );
+            else
+                ret = sendfile( sock_fd, file_fd, &offset, count );
+        } while (ret < 0 && errno == EINTR);
+
+        if (ret >= 0)
+        {
+            TRACE( "sendfile returned %zd\n", ret );
+            async->file_cursor += ret;
+            if (async->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+                async->offset.QuadPart += ret;
+
+            if (ret && (!async->file_len || async->file_cursor < async->file_len))
+                return STATUS_DEVICE_NOT_READY; /* still more data to send */
+            async->file = NULL;
+        }
+        else if (errno == EINVAL || errno == ENOSYS)
+        {
+            /* the file can't be mapped; fall back to copying through the buffer */
+            TRACE( "sendfile not supported, falling back to read\n" );
+            async->no_sendfile = TRUE;
+        }
+        else return sock_errno_to_status( errno );
+    }
+#endif
+
     if (async->file && async->buffer_cursor == async->read_len)
     {
         unsigned int read_size = async->buffer_size;
@@ -1109,6 +1169,7 @@ static NTSTATUS sock_transmit( HANDLE handle, HANDLE event, PIO_APC_ROUTINE apc,
     async->tail = u64_to_user_ptr(params->tail_ptr);
     async->tail_len = params->tail_len;
     async->offset = params->offset;
+    async->no_sendfile = FALSE;
 
     SERVER_START_REQ( send_socket )
     {
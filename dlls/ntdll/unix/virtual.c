@@ -36,6 +36,11 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#ifdef HAVE_LINUX_USERFAULTFD_H
+# include <linux/userfaultfd.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+#endif
 #ifdef HAVE_SYS_SYSINFO_H
 # include <sys/sysinfo.h>
 #endif
@@ -206,9 +211,53 @@ static BYTE *pages_vprot;
 
 static BOOL use_kernel_writewatch;
 static int pagemap_fd, pagemap_reset_fd, clear_refs_fd;
+static int uffd_fd = -1;  /* userfaultfd used for asynchronous write protection, -1 if not used */
 #define PAGE_FLAGS_BUFFER_LENGTH 1024
 #define PM_SOFT_DIRTY_PAGE (1ull << 57)
 
+#ifdef HAVE_LINUX_USERFAULTFD_H
+/* definitions from Linux 6.7, may be missing from older headers */
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1
+#endif
+#ifndef UFFD_FEATURE_WP_UNPOPULATED
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#endif
+#ifndef UFFD_FEATURE_WP_ASYNC
+#define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#endif
+
+#define PAGE_IS_WRITTEN        (1 << 1)
+#define PM_SCAN_WP_MATCHING    (1 << 0)
+#define PM_SCAN_CHECK_WPASYNC  (1 << 1)
+
+struct pagemap_region
+{
+    UINT64 start;
+    UINT64 end;
+    UINT64 categories;
+};
+
+struct pagemap_scan_arg
+{
+    UINT64 size;
+    UINT64 flags;
+    UINT64 start;
+    UINT64 end;
+    UINT64 walk_end;
+    UINT64 vec;
+    UINT64 vec_len;
+    UINT64 max_pages;
+    UINT64 category_inverted;
+    UINT64 category_mask;
+    UINT64 category_anyof_mask;
+    UINT64 return_mask;
+};
+
+#define PAGEMAP_SCAN _IOWR( 'f', 16, struct pagemap_scan_arg )
+#endif
+
+static void register_write_watches( void *base, SIZE_T size );
 static void reset_write_watches( void *base, SIZE_T size );
 
 static struct file_view *view_block_start, *view_block_end, *next_free_view;
@@ -1481,7 +1530,10 @@ static NTSTATUS create_view( struct file_view **view_ret, void *base, size_t siz
     }
 
     if (vprot & VPROT_WRITEWATCH && use_kernel_writewatch)
+    {
+        register_write_watches( view->base, view->size );
         reset_write_watches( view->base, view->size );
+    }
 
     return STATUS_SUCCESS;
 }
@@ -1605,6 +1657,7 @@ static void mprotect_range( void *base, size_t size, BYTE set, BYTE clear )
 static BOOL set_vprot( struct file_view *view, void *base, size_t size, BYTE vprot )
 {
     int unix_prot = get_unix_prot(vprot);
+    BYTE prev_vprot;
 
     if (!use_kernel_writewatch && view->protect & VPROT_WRITEWATCH)
     {
@@ -1613,6 +1666,11 @@ static BOOL set_vprot( struct file_view *view, void *base, size_t size, BYTE vpr
         mprotect_range( base, size, 0, 0 );
         return TRUE;
     }
+    /* avoid the system call, and the time spent holding virtual_mutex, if nothing changes;
+     * native views may have been changed behind our back so always update them */
+    if (!(view->protect & VPROT_NATIVE) &&
+        get_vprot_range_size( base, size, ~0, &prev_vprot ) == size && prev_vprot == vprot)
+        return TRUE;
     if (mprotect_exec( base, size, unix_prot )) return FALSE;
     set_page_vprot( base, size, vprot );
     return TRUE;
@@ -1658,6 +1716,27 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
 }
 
 
+/***********************************************************************
+ *           register_write_watches
+ *
+ * Register a newly mapped write watch range for asynchronous write protection.
+ */
+static void register_write_watches( void *base, SIZE_T size )
+{
+#ifdef HAVE_LINUX_USERFAULTFD_H
+    struct uffdio_register reg;
+
+    if (uffd_fd == -1) return;
+
+    reg.range.start = (ULONG_PTR)base;
+    reg.range.len = size;
+    reg.mode = UFFDIO_REGISTER_MODE_WP;
+    if (ioctl( uffd_fd, UFFDIO_REGISTER, &reg ) == -1)
+        ERR( "Could not register write watch range %p-%p, error %s.\n", base, (char *)base + size, strerror(errno) );
+#endif
+}
+
+
 /***********************************************************************
  *           reset_write_watches
  *
@@ -1665,6 +1744,19 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
  */
 static void reset_write_watches( void *base, SIZE_T size )
 {
+#ifdef HAVE_LINUX_USERFAULTFD_H
+    if (uffd_fd != -1)
+    {
+        struct uffdio_writeprotect wp;
+
+        wp.range.start = (ULONG_PTR)base;
+        wp.range.len = size;
+        wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+        if (ioctl( uffd_fd, UFFDIO_WRITEPROTECT, &wp ) == -1)
+            ERR( "Could not write protect %p-%p, error %s.\n", base, (char *)base + size, strerror(errno) );
+        return;
+    }
+#endif
     if (use_kernel_writewatch)
     {
         char buffer[17];
@@ -2182,6 +2274,12 @@ static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t siz
     if (anon_mmap_fixed( (char *)view->base + start, size, PROT_NONE, 0 ) != MAP_FAILED)
     {
         set_page_vprot_bits( (char *)view->base + start, size, 0, VPROT_COMMITTED );
+        if (view->protect & VPROT_WRITEWATCH && uffd_fd != -1)
+        {
+            /* the new mapping is no longer registered */
+            register_write_watches( (char *)view->base + start, size );
+            reset_write_watches( (char *)view->base + start, size );
+        }
         return STATUS_SUCCESS;
     }
     return STATUS_NO_MEMORY;
@@ -2744,6 +2842,94 @@ static int alloc_virtual_heap( void *base, SIZE_T size, void *arg )
     return (alloc->base != MAP_FAILED);
 }
 
+/***********************************************************************
+ *           init_uffd_write_watches
+ *
+ * Check for userfaultfd asynchronous write protection and the PAGEMAP_SCAN ioctl (Linux 6.7).
+ */
+static BOOL init_uffd_write_watches(void)
+{
+#if defined(HAVE_LINUX_USERFAULTFD_H) && defined(__NR_userfaultfd)
+    static const UINT64 features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED;
+    struct pagemap_scan_arg arg;
+    struct uffdio_api api;
+    int fd;
+
+    if ((uffd_fd = syscall( __NR_userfaultfd, UFFD_USER_MODE_ONLY | O_CLOEXEC | O_NONBLOCK )) == -1)
+        return FALSE;
+    api.api = UFFD_API;
+    api.features = features;
+    api.ioctls = 0;
+    if (ioctl( uffd_fd, UFFDIO_API, &api ) == -1 || (api.features & features) != features) goto failed;
+
+    if ((fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC )) == -1) goto failed;
+    memset( &arg, 0, sizeof(arg) );
+    arg.size = sizeof(arg);
+    if (ioctl( fd, PAGEMAP_SCAN, &arg ) == -1)
+    {
+        close( fd );
+        goto failed;
+    }
+    pagemap_fd = fd;
+    return TRUE;
+
+failed:
+    close( uffd_fd );
+    uffd_fd = -1;
+#endif
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           get_uffd_write_watches
+ *
+ * Retrieve the written pages of a range with PAGEMAP_SCAN, optionally write protecting them again.
+ * virtual_mutex must be held by caller.
+ */
+static NTSTATUS get_uffd_write_watches( char *base, char *end, BOOL reset, PVOID *addresses, ULONG_PTR *count )
+{
+#ifdef HAVE_LINUX_USERFAULTFD_H
+    static struct pagemap_region regions[PAGE_FLAGS_BUFFER_LENGTH];
+    struct pagemap_scan_arg arg;
+    ULONG_PTR pos = 0;
+    char *addr;
+    int i, ret;
+
+    memset( &arg, 0, sizeof(arg) );
+    arg.size = sizeof(arg);
+    arg.flags = reset ? PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC : 0;
+    arg.start = (ULONG_PTR)base;
+    arg.end = (ULONG_PTR)end;
+    arg.vec = (ULONG_PTR)regions;
+    arg.vec_len = ARRAY_SIZE(regions);
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask = PAGE_IS_WRITTEN;
+
+    while (pos < *count && arg.start < arg.end)
+    {
+        arg.max_pages = *count - pos;
+        if ((ret = ioctl( pagemap_fd, PAGEMAP_SCAN, &arg )) == -1)
+        {
+            ERR( "Error scanning page flags, error %s.\n", strerror(errno) );
+            return STATUS_INVALID_ADDRESS;
+        }
+        for (i = 0; i < ret; i++)
+            for (addr = (char *)(ULONG_PTR)regions[i].start;
+                 addr < (char *)(ULONG_PTR)regions[i].end && pos < *count;
+                 addr += page_size)
+                addresses[pos++] = addr;
+        if (arg.walk_end <= arg.start) break;
+        arg.start = arg.walk_end;
+    }
+    *count = pos;
+    return STATUS_SUCCESS;
+#else
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
+
+
 /***********************************************************************
  *           virtual_init
  */
@@ -2763,6 +2949,12 @@ void virtual_init(void)
     pthread_mutexattr_destroy( &attr );
 
     if (!((env_var = getenv("WINE_DISABLE_KERNEL_WRITEWATCH")) && atoi(env_var))
+            && init_uffd_write_watches())
+    {
+        use_kernel_writewatch = TRUE;
+        TRACE( "using userfaultfd write watches\n" );
+    }
+    else if (!(env_var && atoi(env_var))
             && (pagemap_reset_fd = open("/proc/self/pagemap_reset", O_RDONLY)) != -1)
     {
         use_kernel_writewatch = TRUE;
@@ -5040,7 +5232,13 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
         char *addr = base;
         char *end = addr + size;
 
-        if (use_kernel_writewatch)
+        if (uffd_fd != -1)
+        {
+            status = get_uffd_write_watches( addr, end, flags & WRITE_WATCH_FLAG_RESET, addresses, count );
+            *granularity = page_size;
+            goto done;
+        }
+        else if (use_kernel_writewatch)
         {
             static UINT64 buffer[PAGE_FLAGS_BUFFER_LENGTH];
             unsigned int i, length;
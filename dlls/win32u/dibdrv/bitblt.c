@@ -23,6 +23,8 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
 
 #include "ntgdi_private.h"
 #include "dibdrv.h"
@@ -585,17 +587,159 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+/* Large blends and gradients can optionally be split into bands of rows that
+ * are rendered in parallel. This is enabled by setting WINE_DIB_THREADS to the
+ * number of worker threads. It is off by default: the workers are plain unix
+ * threads, so they can't handle faults on application memory the way the
+ * calling thread does. */
+
+#define BAND_MIN_PIXELS  (256 * 256)
+#define BAND_MIN_HEIGHT  16
+#define BAND_MAX_THREADS 32
+
+struct band_job
+{
+    void      (*func)( void *ctx, const RECT *rect );
+    void       *ctx;
+    const RECT *rect;
+    int         band_height;
+    int         band_count;
+    int         next_band;   /* next band to render */
+    int         pending;     /* bands that aren't finished yet */
+};
+
+static pthread_once_t band_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t band_dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t band_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t band_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t band_done_cond = PTHREAD_COND_INITIALIZER;
+static struct band_job *band_job;
+static int band_thread_count;
+
+/* render the next band of a job, called with band_lock held */
+static BOOL render_next_band( struct band_job *job )
+{
+    RECT rect = *job->rect;
+    int band;
+
+    if (job->next_band == job->band_count) return FALSE;
+    band = job->next_band++;
+    pthread_mutex_unlock( &band_lock );
+
+    rect.top += band * job->band_height;
+    rect.bottom = min( rect.top + job->band_height, job->rect->bottom );
+    job->func( job->ctx, &rect );
+
+    pthread_mutex_lock( &band_lock );
+    if (!--job->pending) pthread_cond_signal( &band_done_cond );
+    return TRUE;
+}
+
+static void *band_thread( void *arg )
+{
+    pthread_mutex_lock( &band_lock );
+    for (;;)
+    {
+        while (!band_job || !render_next_band( band_job ))
+            pthread_cond_wait( &band_work_cond, &band_lock );
+    }
+    return NULL;
+}
+
+static void init_band_threads(void)
+{
+    const char *env = getenv( "WINE_DIB_THREADS" );
+    pthread_t thread;
+    int i, count;
+
+    if (!env || (count = atoi( env )) <= 0) return;
+    count = min( count, BAND_MAX_THREADS );
+
+    for (i = 0; i < count; i++)
+    {
+        if (pthread_create( &thread, NULL, band_thread, NULL )) break;
+        pthread_detach( thread );
+    }
+    band_thread_count = i;
+    TRACE( "using %d threads for large operations\n", band_thread_count );
+}
+
+static BOOL use_band_threads(void)
+{
+    pthread_once( &band_once, init_band_threads );
+    return band_thread_count != 0;
+}
+
+/* Call func for the whole rectangle, or for bands of it on several threads
+ * when it is large enough. Bands don't overlap, and func must produce the
+ * same pixels whichever way the rectangle is split. */
+static void render_bands( const RECT *rect, void (*func)( void *ctx, const RECT *rect ), void *ctx )
+{
+    struct band_job job;
+    int height = rect->bottom - rect->top;
+
+    if ((rect->right - rect->left) * height < BAND_MIN_PIXELS || height < 2 * BAND_MIN_HEIGHT ||
+        pthread_mutex_trylock( &band_dispatch_lock ))
+    {
+        func( ctx, rect );
+        return;
+    }
+
+    job.func = func;
+    job.ctx = ctx;
+    job.rect = rect;
+    job.band_count = min( band_thread_count + 1, height / BAND_MIN_HEIGHT );
+    job.band_height = (height + job.band_count - 1) / job.band_count;
+    job.band_count = (height + job.band_height - 1) / job.band_height;
+    job.next_band = 0;
+    job.pending = job.band_count;
+
+    pthread_mutex_lock( &band_lock );
+    band_job = &job;
+    pthread_cond_broadcast( &band_work_cond );
+    while (render_next_band( &job ));
+    while (job.pending) pthread_cond_wait( &band_done_cond, &band_lock );
+    band_job = NULL;
+    pthread_mutex_unlock( &band_lock );
+
+    pthread_mutex_unlock( &band_dispatch_lock );
+}
+
+struct blend_band_ctx
+{
+    dib_info       *dst;
+    const dib_info *src;
+    POINT           offset;
+    BLENDFUNCTION   blend;
+};
+
+static void blend_band( void *ctx, const RECT *rect )
+{
+    struct blend_band_ctx *blend = ctx;
+
+    blend->dst->funcs->blend_rects( blend->dst, 1, rect, blend->src, &blend->offset, blend->blend );
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
     POINT offset;
     struct clipped_rects clipped_rects;
+    int i;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
 
     offset.x = src_rect->left - dst_rect->left;
     offset.y = src_rect->top  - dst_rect->top;
-    dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
+    /* bands must not read rows written by another band */
+    if (use_band_threads() && src->bits.ptr != dst->bits.ptr)
+    {
+        struct blend_band_ctx ctx = { dst, src, offset, blend };
+
+        for (i = 0; i < clipped_rects.count; i++)
+            render_bands( &clipped_rects.rects[i], blend_band, &ctx );
+    }
+    else dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
 
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -680,6 +824,22 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
+struct gradient_band_ctx
+{
+    dib_info       *dib;
+    const TRIVERTEX *v;
+    int             mode;
+    BOOL            ret;
+};
+
+static void gradient_band( void *ctx, const RECT *rect )
+{
+    struct gradient_band_ctx *gradient = ctx;
+
+    if (!gradient->dib->funcs->gradient_rect( gradient->dib, rect, gradient->v, gradient->mode ))
+        gradient->ret = FALSE;
+}
+
 static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
 {
     int i;
@@ -689,7 +849,15 @@ static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, con
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
     for (i = 0; i < clipped_rects.count; i++)
     {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
+        if (use_band_threads())
+        {
+            struct gradient_band_ctx ctx = { dib, v, mode, TRUE };
+
+            render_bands( &clipped_rects.rects[i], gradient_band, &ctx );
+            ret = ctx.ret;
+        }
+        else ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode );
+        if (!ret) break;
     }
     free_clipped_rects( &clipped_rects );
     return ret;
@@ -23,6 +23,9 @@
 #endif
 
 #include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ntgdi_private.h"
 #include "dibdrv.h"
@@ -268,10 +271,25 @@ static inline void memset_16( WORD *start, WORD val, DWORD size )
 #endif
 }
 
+static inline void do_rop_line_32( DWORD *ptr, DWORD and, DWORD xor, int len )
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i and_vec = _mm_set1_epi32( and ), xor_vec = _mm_set1_epi32( xor );
+
+    for (; x + 4 <= len; x += 4)
+    {
+        __m128i val = _mm_loadu_si128( (const __m128i *)(ptr + x) );
+        _mm_storeu_si128( (__m128i *)(ptr + x), _mm_xor_si128( _mm_and_si128( val, and_vec ), xor_vec ));
+    }
+#endif
+    for (; x < len; x++) do_rop_32( ptr + x, and, xor );
+}
+
 static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor)
 {
-    DWORD *ptr, *start;
-    int x, y, i;
+    DWORD *start;
+    int y, i;
 
     for(i = 0; i < num; i++, rc++)
     {
@@ -280,8 +298,7 @@ static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD a
         start = get_pixel_ptr_32(dib, rc->left, rc->top);
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
-                for(x = rc->left, ptr = start; x < rc->right; x++)
-                    do_rop_32(ptr++, and, xor);
+                do_rop_line_32( start, and, xor, rc->right - rc->left );
         else
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
                 memset_32( start, xor, rc->right - rc->left );
@@ -4682,34 +4699,143 @@ static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BL
             blend_color( dst_r, src >> 16, blend.SourceConstantAlpha ) << 16);
 }
 
+#ifdef __SSE2__
+
+/* (val + 127) / 255 for each 16-bit lane, for values up to 255 * 255 */
+static inline __m128i div255_sse2( __m128i val )
+{
+    val = _mm_add_epi16( val, _mm_set1_epi16( 128 ));
+    return _mm_srli_epi16( _mm_add_epi16( val, _mm_srli_epi16( val, 8 )), 8 );
+}
+
+/* Pack the per-channel sums of blend_argb() for four pixels. A sum can
+ * exceed 255 when the source isn't properly premultiplied; the scalar code
+ * then carries the overflow into the next channel, so do the same. */
+static inline __m128i pack_argb_sums_sse2( __m128i lo, __m128i hi )
+{
+    const __m128i mask = _mm_set1_epi16( 0xff );
+
+    lo = _mm_or_si128( _mm_and_si128( lo, mask ), _mm_slli_epi64( _mm_srli_epi16( lo, 8 ), 16 ));
+    hi = _mm_or_si128( _mm_and_si128( hi, mask ), _mm_slli_epi64( _mm_srli_epi16( hi, 8 ), 16 ));
+    return _mm_packus_epi16( lo, hi );
+}
+
+/* Same as blend_argb() for two pixels unpacked to 16-bit lanes */
+static inline __m128i blend_argb_sse2( __m128i dst, __m128i src )
+{
+    __m128i alpha = _mm_shufflehi_epi16( _mm_shufflelo_epi16( src, 0xff ), 0xff );
+
+    alpha = _mm_sub_epi16( _mm_set1_epi16( 255 ), alpha );
+    return _mm_add_epi16( src, div255_sse2( _mm_mullo_epi16( dst, alpha )));
+}
+
+/* Same as blend_argb_alpha(), or blend_argb() when alpha is 255; returns the number of pixels done */
+static inline int blend_argb_line_simd( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128(), alpha_mask = _mm_set1_epi32( 0xff000000 );
+    const __m128i const_alpha = _mm_set1_epi16( alpha );
+    __m128i src_val, dst_val, src_lo, src_hi, lo, hi;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        src_val = _mm_loadu_si128( (const __m128i *)(src + x) );
+
+        /* Fully transparent pixels are common, and leave the destination untouched. */
+        if (_mm_movemask_epi8( _mm_cmpeq_epi32( src_val, zero )) == 0xffff) continue;
+        if (alpha == 255 && _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( src_val, alpha_mask ),
+                                                                 alpha_mask )) == 0xffff)
+        {
+            _mm_storeu_si128( (__m128i *)(dst + x), src_val );
+            continue;
+        }
+
+        dst_val = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        src_lo = _mm_unpacklo_epi8( src_val, zero );
+        src_hi = _mm_unpackhi_epi8( src_val, zero );
+        if (alpha != 255)
+        {
+            src_lo = div255_sse2( _mm_mullo_epi16( src_lo, const_alpha ));
+            src_hi = div255_sse2( _mm_mullo_epi16( src_hi, const_alpha ));
+        }
+        lo = blend_argb_sse2( _mm_unpacklo_epi8( dst_val, zero ), src_lo );
+        hi = blend_argb_sse2( _mm_unpackhi_epi8( dst_val, zero ), src_hi );
+        _mm_storeu_si128( (__m128i *)(dst + x), pack_argb_sums_sse2( lo, hi ));
+    }
+    return x;
+}
+
+/* Same as blend_argb_constant_alpha(), or blend_argb_no_src_alpha() when src_alpha
+ * is 0xff000000; returns the number of pixels done */
+static inline int blend_constant_alpha_line_simd( DWORD *dst, const DWORD *src, int len,
+                                                   DWORD alpha, DWORD src_alpha )
+{
+    const __m128i zero = _mm_setzero_si128(), src_or = _mm_set1_epi32( src_alpha );
+    const __m128i src_mul = _mm_set1_epi16( alpha ), dst_mul = _mm_set1_epi16( 255 - alpha );
+    __m128i src_val, dst_val, lo, hi;
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+    {
+        src_val = _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + x) ), src_or );
+        dst_val = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( src_val, zero ), src_mul ),
+                            _mm_mullo_epi16( _mm_unpacklo_epi8( dst_val, zero ), dst_mul ));
+        hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( src_val, zero ), src_mul ),
+                            _mm_mullo_epi16( _mm_unpackhi_epi8( dst_val, zero ), dst_mul ));
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packus_epi16( div255_sse2( lo ), div255_sse2( hi )));
+    }
+    return x;
+}
+
+#else  /* __SSE2__ */
+
+static inline int blend_argb_line_simd( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    return 0;
+}
+
+static inline int blend_constant_alpha_line_simd( DWORD *dst, const DWORD *src, int len,
+                                                   DWORD alpha, DWORD src_alpha )
+{
+    return 0;
+}
+
+#endif /* __SSE2__ */
+
 static void blend_rects_8888(const dib_info *dst, int num, const RECT *rc,
                              const dib_info *src, const POINT *offset, BLENDFUNCTION blend)
 {
-    int i, x, y;
+    int i, x, y, width;
 
     for (i = 0; i < num; i++, rc++)
     {
         DWORD *src_ptr = get_pixel_ptr_32( src, rc->left + offset->x, rc->top + offset->y );
         DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
 
+        width = rc->right - rc->left;
         if (blend.AlphaFormat & AC_SRC_ALPHA)
         {
             if (blend.SourceConstantAlpha == 255)
                 for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                    for (x = 0; x < rc->right - rc->left; x++)
+                    for (x = blend_argb_line_simd( dst_ptr, src_ptr, width, 255 ); x < width; x++)
                         dst_ptr[x] = blend_argb( dst_ptr[x], src_ptr[x] );
             else
                 for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                    for (x = 0; x < rc->right - rc->left; x++)
+                    for (x = blend_argb_line_simd( dst_ptr, src_ptr, width, blend.SourceConstantAlpha );
+                         x < width; x++)
                         dst_ptr[x] = blend_argb_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
         }
         else if (src->compression == BI_RGB)
             for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                for (x = 0; x < rc->right - rc->left; x++)
+                for (x = blend_constant_alpha_line_simd( dst_ptr, src_ptr, width, blend.SourceConstantAlpha, 0 );
+                     x < width; x++)
                     dst_ptr[x] = blend_argb_constant_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
         else
             for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-                for (x = 0; x < rc->right - rc->left; x++)
+                for (x = blend_constant_alpha_line_simd( dst_ptr, src_ptr, width, blend.SourceConstantAlpha,
+                                                         0xff000000 );
+                     x < width; x++)
                     dst_ptr[x] = blend_argb_no_src_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
     }
 }
@@ -4757,25 +4883,47 @@ static void blend_rects_32(const dib_info *dst, int num, const RECT *rc,
     }
 }
 
+/* Blend a line of 24 or 16-bpp pixels that have been expanded to 0x00rrggbb */
+static void blend_rgb_line( DWORD *dst, const DWORD *src, int len, BLENDFUNCTION blend )
+{
+    int x;
+
+    if (blend.AlphaFormat & AC_SRC_ALPHA)
+        x = blend_argb_line_simd( dst, src, len, blend.SourceConstantAlpha );
+    else
+        x = blend_constant_alpha_line_simd( dst, src, len, blend.SourceConstantAlpha, 0 );
+
+    for (; x < len; x++) dst[x] = blend_rgb( dst[x] >> 16, dst[x] >> 8, dst[x], src[x], blend );
+}
+
 static void blend_rects_24(const dib_info *dst, int num, const RECT *rc,
                            const dib_info *src, const POINT *offset, BLENDFUNCTION blend)
 {
-    int i, x, y;
+    int i, j, x, y, len, width;
+    DWORD buf[64];
 
     for (i = 0; i < num; i++, rc++)
     {
         DWORD *src_ptr = get_pixel_ptr_32( src, rc->left + offset->x, rc->top + offset->y );
         BYTE *dst_ptr = get_pixel_ptr_24( dst, rc->left, rc->top );
 
+        width = rc->right - rc->left;
         for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride, src_ptr += src->stride / 4)
         {
-            for (x = 0; x < rc->right - rc->left; x++)
+            for (x = 0; x < width; x += len)
             {
-                DWORD val = blend_rgb( dst_ptr[x * 3 + 2], dst_ptr[x * 3 + 1], dst_ptr[x * 3],
-                                       src_ptr[x], blend );
-                dst_ptr[x * 3]     = val;
-                dst_ptr[x * 3 + 1] = val >> 8;
-                dst_ptr[x * 3 + 2] = val >> 16;
+                BYTE *ptr = dst_ptr + x * 3;
+
+                len = min( width - x, ARRAY_SIZE(buf) );
+                for (j = 0; j < len; j++)
+                    buf[j] = ptr[j * 3] | ptr[j * 3 + 1] << 8 | ptr[j * 3 + 2] << 16;
+                blend_rgb_line( buf, src_ptr + x, len, blend );
+                for (j = 0; j < len; j++)
+                {
+                    ptr[j * 3]     = buf[j];
+                    ptr[j * 3 + 1] = buf[j] >> 8;
+                    ptr[j * 3 + 2] = buf[j] >> 16;
+                }
             }
         }
     }
@@ -4784,22 +4932,29 @@ static void blend_rects_24(const dib_info *dst, int num, const RECT *rc,
 static void blend_rects_555(const dib_info *dst, int num, const RECT *rc,
                             const dib_info *src, const POINT *offset, BLENDFUNCTION blend)
 {
-    int i, x, y;
+    int i, j, x, y, len, width;
+    DWORD buf[64];
 
     for (i = 0; i < num; i++, rc++)
     {
         DWORD *src_ptr = get_pixel_ptr_32( src, rc->left + offset->x, rc->top + offset->y );
         WORD *dst_ptr = get_pixel_ptr_16( dst, rc->left, rc->top );
 
+        width = rc->right - rc->left;
         for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 2, src_ptr += src->stride / 4)
         {
-            for (x = 0; x < rc->right - rc->left; x++)
+            for (x = 0; x < width; x += len)
             {
-                DWORD val = blend_rgb( ((dst_ptr[x] >> 7) & 0xf8) | ((dst_ptr[x] >> 12) & 0x07),
-                                       ((dst_ptr[x] >> 2) & 0xf8) | ((dst_ptr[x] >>  7) & 0x07),
-                                       ((dst_ptr[x] << 3) & 0xf8) | ((dst_ptr[x] >>  2) & 0x07),
-                                       src_ptr[x], blend );
-                dst_ptr[x] = ((val >> 9) & 0x7c00) | ((val >> 6) & 0x03e0) | ((val >> 3) & 0x001f);
+                WORD *ptr = dst_ptr + x;
+
+                len = min( width - x, ARRAY_SIZE(buf) );
+                for (j = 0; j < len; j++)
+                    buf[j] = ((ptr[j] << 9) & 0xf80000) | ((ptr[j] << 4) & 0x070000) |
+                             ((ptr[j] << 6) & 0x00f800) | ((ptr[j] << 1) & 0x000700) |
+                             ((ptr[j] << 3) & 0x0000f8) | ((ptr[j] >> 2) & 0x000007);
+                blend_rgb_line( buf, src_ptr + x, len, blend );
+                for (j = 0; j < len; j++)
+                    ptr[j] = ((buf[j] >> 9) & 0x7c00) | ((buf[j] >> 6) & 0x03e0) | ((buf[j] >> 3) & 0x001f);
             }
         }
     }
@@ -4808,22 +4963,29 @@ static void blend_rects_555(const dib_info *dst, int num, const RECT *rc,
 static void blend_rects_16(const dib_info *dst, int num, const RECT *rc,
                            const dib_info *src, const POINT *offset, BLENDFUNCTION blend)
 {
-    int i, x, y;
+    int i, j, x, y, len, width;
+    DWORD buf[64];
 
     for (i = 0; i < num; i++, rc++)
     {
         DWORD *src_ptr = get_pixel_ptr_32( src, rc->left + offset->x, rc->top + offset->y );
         WORD *dst_ptr = get_pixel_ptr_16( dst, rc->left, rc->top );
 
+        width = rc->right - rc->left;
         for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 2, src_ptr += src->stride / 4)
         {
-            for (x = 0; x < rc->right - rc->left; x++)
+            for (x = 0; x < width; x += len)
             {
-                DWORD val = blend_rgb( get_field( dst_ptr[x], dst->red_shift, dst->red_len ),
-                                       get_field( dst_ptr[x], dst->green_shift, dst->green_len ),
-                                       get_field( dst_ptr[x], dst->blue_shift, dst->blue_len ),
-                                       src_ptr[x], blend );
-                dst_ptr[x] = rgb_to_pixel_masks( dst, val >> 16, val >> 8, val );
+                WORD *ptr = dst_ptr + x;
+
+                len = min( width - x, ARRAY_SIZE(buf) );
+                for (j = 0; j < len; j++)
+                    buf[j] = get_field( ptr[j], dst->red_shift, dst->red_len ) << 16 |
+                             get_field( ptr[j], dst->green_shift, dst->green_len ) << 8 |
+                             get_field( ptr[j], dst->blue_shift, dst->blue_len );
+                blend_rgb_line( buf, src_ptr + x, len, blend );
+                for (j = 0; j < len; j++)
+                    ptr[j] = rgb_to_pixel_masks( dst, buf[j] >> 16, buf[j] >> 8, buf[j] );
             }
         }
     }
@@ -6138,15 +6300,42 @@ static void draw_glyph_8888( const dib_info *dib, const RECT *rect, const dib_in
 {
     DWORD *dst_ptr = get_pixel_ptr_32( dib, rect->left, rect->top );
     const BYTE *glyph_ptr = get_pixel_ptr_8( glyph, origin->x, origin->y );
-    int x, y;
+    int x, y, end, width = rect->right - rect->left;
+#ifdef __SSE2__
+    const __m128i one = _mm_set1_epi8( 1 ), sixteen = _mm_set1_epi8( 16 );
+    const __m128i text = _mm_set1_epi32( text_pixel );
+#endif
 
     for (y = rect->top; y < rect->bottom; y++)
     {
-        for (x = 0; x < rect->right - rect->left; x++)
+        for (x = 0; x < width; x = end)
         {
-            if (glyph_ptr[x] <= 1) continue;
-            if (glyph_ptr[x] >= 16) { dst_ptr[x] = text_pixel; continue; }
-            dst_ptr[x] = aa_rgb( dst_ptr[x] >> 16, dst_ptr[x] >> 8, dst_ptr[x], text_pixel, ranges + glyph_ptr[x] );
+            end = min( x + 16, width );
+#ifdef __SSE2__
+            /* Most of a glyph is either fully transparent or fully opaque;
+             * deal with runs of 16 such pixels at once. */
+            if (end - x == 16)
+            {
+                __m128i val = _mm_loadu_si128( (const __m128i *)(glyph_ptr + x) );
+
+                if (_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_min_epu8( val, one ), val )) == 0xffff)
+                    continue;
+                if (_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_max_epu8( val, sixteen ), val )) == 0xffff)
+                {
+                    _mm_storeu_si128( (__m128i *)(dst_ptr + x), text );
+                    _mm_storeu_si128( (__m128i *)(dst_ptr + x + 4), text );
+                    _mm_storeu_si128( (__m128i *)(dst_ptr + x + 8), text );
+                    _mm_storeu_si128( (__m128i *)(dst_ptr + x + 12), text );
+                    continue;
+                }
+            }
+#endif
+            for (; x < end; x++)
+            {
+                if (glyph_ptr[x] <= 1) continue;
+                if (glyph_ptr[x] >= 16) { dst_ptr[x] = text_pixel; continue; }
+                dst_ptr[x] = aa_rgb( dst_ptr[x] >> 16, dst_ptr[x] >> 8, dst_ptr[x], text_pixel, ranges + glyph_ptr[x] );
+            }
         }
         dst_ptr += dib->stride / 4;
         glyph_ptr += glyph->stride;
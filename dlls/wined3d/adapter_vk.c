@@ -394,6 +394,157 @@ static const struct wined3d_allocator_ops wined3d_allocator_vk_ops =
     .allocator_destroy_chunk = wined3d_allocator_vk_destroy_chunk,
 };
 
+/* Upper bound for the size of the pipeline cache read from and written to
+ * disk; larger caches are not saved. */
+#define WINED3D_VK_PIPELINE_CACHE_MAX_SIZE (64u * 1024 * 1024)
+
+static void *wined3d_load_vk_pipeline_cache_data(const struct wined3d_adapter_vk *adapter_vk, size_t *size)
+{
+    const char *path = wined3d_settings.vk_pipeline_cache;
+    VkPipelineCacheHeaderVersionOne *header;
+    LARGE_INTEGER file_size;
+    void *data = NULL;
+    DWORD read;
+    HANDLE file;
+
+    if ((file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        TRACE("No pipeline cache found at %s.\n", debugstr_a(path));
+        return NULL;
+    }
+
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < sizeof(*header)
+            || file_size.QuadPart > WINED3D_VK_PIPELINE_CACHE_MAX_SIZE)
+    {
+        WARN("Ignoring pipeline cache %s with invalid size.\n", debugstr_a(path));
+        goto done;
+    }
+
+    if (!(data = heap_alloc(file_size.u.LowPart)))
+        goto done;
+    if (!ReadFile(file, data, file_size.u.LowPart, &read, NULL) || read != file_size.u.LowPart)
+    {
+        WARN("Failed to read pipeline cache %s.\n", debugstr_a(path));
+        heap_free(data);
+        data = NULL;
+        goto done;
+    }
+
+    /* The driver is supposed to reject incompatible data, but don't rely on it. */
+    header = data;
+    if (header->headerSize < sizeof(*header) || header->headerSize > read
+            || header->headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            || header->vendorID != adapter_vk->vendor_id || header->deviceID != adapter_vk->device_id
+            || memcmp(header->pipelineCacheUUID, adapter_vk->pipeline_cache_uuid, VK_UUID_SIZE))
+    {
+        TRACE("Discarding pipeline cache %s created by a different driver.\n", debugstr_a(path));
+        heap_free(data);
+        data = NULL;
+        goto done;
+    }
+
+    TRACE("Loaded %u bytes of pipeline cache data from %s.\n", read, debugstr_a(path));
+    *size = read;
+
+done:
+    CloseHandle(file);
+    return data;
+}
+
+static void wined3d_device_vk_create_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkPipelineCacheCreateInfo cache_desc;
+    void *data = NULL;
+    size_t size = 0;
+    VkResult vr;
+
+    if (wined3d_settings.vk_pipeline_cache)
+        data = wined3d_load_vk_pipeline_cache_data(adapter_vk, &size);
+
+    cache_desc.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_desc.pNext = NULL;
+    cache_desc.flags = 0;
+    cache_desc.initialDataSize = size;
+    cache_desc.pInitialData = data;
+    if ((vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_desc,
+            NULL, &device_vk->vk_pipeline_cache))) < 0 && data)
+    {
+        WARN("Failed to create pipeline cache from saved data, vr %s.\n", wined3d_debug_vkresult(vr));
+        cache_desc.initialDataSize = 0;
+        cache_desc.pInitialData = NULL;
+        vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_desc, NULL, &device_vk->vk_pipeline_cache));
+    }
+    if (vr < 0)
+    {
+        WARN("Failed to create pipeline cache, vr %s.\n", wined3d_debug_vkresult(vr));
+        device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+    }
+
+    heap_free(data);
+}
+
+static void wined3d_device_vk_save_pipeline_cache(struct wined3d_device_vk *device_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    const char *path = wined3d_settings.vk_pipeline_cache;
+    char tmp_path[MAX_PATH];
+    void *data = NULL;
+    size_t size;
+    DWORD written;
+    HANDLE file;
+    VkResult vr;
+
+    if ((vr = VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &size, NULL))) < 0)
+    {
+        WARN("Failed to get pipeline cache size, vr %s.\n", wined3d_debug_vkresult(vr));
+        return;
+    }
+    if (size > WINED3D_VK_PIPELINE_CACHE_MAX_SIZE)
+    {
+        WARN("Not saving pipeline cache of %lu bytes.\n", (unsigned long)size);
+        return;
+    }
+    if (!(data = heap_alloc(size)))
+        return;
+    if ((vr = VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &size, data))) < 0)
+    {
+        WARN("Failed to get pipeline cache data, vr %s.\n", wined3d_debug_vkresult(vr));
+        goto done;
+    }
+
+    /* Write to a temporary file first, so that concurrent processes never
+     * see a partially written cache. */
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.%x", path, GetCurrentProcessId()) >= sizeof(tmp_path))
+        goto done;
+    if ((file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(tmp_path), GetLastError());
+        goto done;
+    }
+    if (!WriteFile(file, data, size, &written, NULL) || written != size)
+    {
+        WARN("Failed to write pipeline cache, error %u.\n", GetLastError());
+        CloseHandle(file);
+        DeleteFileA(tmp_path);
+        goto done;
+    }
+    CloseHandle(file);
+
+    if (!MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to replace %s, error %u.\n", debugstr_a(path), GetLastError());
+        DeleteFileA(tmp_path);
+        goto done;
+    }
+    TRACE("Saved %lu bytes of pipeline cache data to %s.\n", (unsigned long)size, debugstr_a(path));
+
+done:
+    heap_free(data);
+}
+
 static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wined3d_adapter *adapter,
         enum wined3d_device_type device_type, HWND focus_window, unsigned int flags, BYTE surface_alignment,
         const enum wined3d_feature_level *levels, unsigned int level_count,
@@ -510,11 +661,14 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
         goto fail;
     }
 
+    wined3d_device_vk_create_pipeline_cache(device_vk, adapter_vk);
+
     if (FAILED(hr = wined3d_device_init(&device_vk->d, wined3d, adapter->ordinal, device_type, focus_window,
             flags, surface_alignment, levels, level_count, vk_info->supported, device_parent)))
     {
         WARN("Failed to initialize device, hr %#x.\n", hr);
         wined3d_allocator_cleanup(&device_vk->allocator);
+        VK_CALL(vkDestroyPipelineCache(vk_device, device_vk->vk_pipeline_cache, NULL));
         goto fail;
     }
 
@@ -544,6 +698,12 @@ static void adapter_vk_destroy_device(struct wined3d_device *device)
         device_vk->allocator_cs.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection(&device_vk->allocator_cs);
 
+    if (device_vk->vk_pipeline_cache)
+    {
+        if (wined3d_settings.vk_pipeline_cache)
+            wined3d_device_vk_save_pipeline_cache(device_vk);
+        VK_CALL(vkDestroyPipelineCache(device_vk->vk_device, device_vk->vk_pipeline_cache, NULL));
+    }
     VK_CALL(vkDestroyDevice(device_vk->vk_device, NULL));
     heap_free(device_vk);
 }
@@ -2475,6 +2635,9 @@ static BOOL wined3d_adapter_vk_init(struct wined3d_adapter_vk *adapter_vk,
     else
         VK_CALL(vkGetPhysicalDeviceProperties(adapter_vk->physical_device, &properties2.properties));
     adapter_vk->device_limits = properties2.properties.limits;
+    adapter_vk->vendor_id = properties2.properties.vendorID;
+    adapter_vk->device_id = properties2.properties.deviceID;
+    memcpy(adapter_vk->pipeline_cache_uuid, properties2.properties.pipelineCacheUUID, VK_UUID_SIZE);
 
     VK_CALL(vkGetPhysicalDeviceMemoryProperties(adapter_vk->physical_device, &adapter_vk->memory_properties));
 
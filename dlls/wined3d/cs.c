@@ -20,6 +20,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
 
@@ -728,6 +729,7 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
     }
 
     InterlockedDecrement(&cs->pending_presents);
+    RtlWakeAddressAll(&cs->pending_presents);
 }
 
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain,
@@ -761,7 +763,7 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
      * ahead of the worker thread. */
     while (pending >= swapchain->max_frame_latency)
     {
-        YieldProcessor();
+        RtlWaitOnAddress(&cs->pending_presents, &pending, sizeof(pending), NULL);
         pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
     }
 }
@@ -3214,6 +3216,61 @@ static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct
     return *(volatile LONG *)&queue->head == queue->tail;
 }
 
+static ULONG64 wined3d_cs_get_ticks(void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+/* Spin for twice as long as the last wait that was satisfied by spinning,
+ * and back off once spinning stops paying off. */
+static unsigned int wined3d_cs_adapt_spin_limit(unsigned int limit,
+        unsigned int max_limit, unsigned int spin_count, BOOL slept)
+{
+    if (slept)
+        return max(limit / 2, WINED3D_CS_SPIN_COUNT_MIN);
+    if (spin_count > max_limit / 2)
+        return max_limit;
+    return max(limit, spin_count * 2);
+}
+
+/* Wait for the CS thread to move the tail of "queue" away from "tail". The
+ * CS thread usually catches up quickly, so spin first; if that doesn't help,
+ * block until the CS thread wakes us. "waiters" determines when it does. */
+static void wined3d_cs_queue_wait_tail(struct wined3d_cs *cs, struct wined3d_cs_queue *queue,
+        LONG tail, LONG *waiters)
+{
+    ULONG64 start = wined3d_cs_get_ticks();
+    unsigned int spin_count = 0;
+
+    while (*(volatile LONG *)&queue->tail == tail)
+    {
+        if (++spin_count < cs->wait_spin_limit)
+        {
+            YieldProcessor();
+            continue;
+        }
+
+        cs->wait_stats.wait_spin_ticks += wined3d_cs_get_ticks() - start;
+        cs->wait_spin_limit = wined3d_cs_adapt_spin_limit(cs->wait_spin_limit,
+                WINED3D_CS_WAIT_SPIN_COUNT, spin_count, TRUE);
+        ++cs->wait_stats.wait_sleeps;
+
+        /* RtlWaitOnAddress() compares the tail again after "waiters" is
+         * incremented, so a concurrent tail update can't be missed. */
+        InterlockedIncrement(waiters);
+        RtlWaitOnAddress(&queue->tail, &tail, sizeof(tail), NULL);
+        InterlockedDecrement(waiters);
+        return;
+    }
+
+    cs->wait_stats.wait_spin_ticks += wined3d_cs_get_ticks() - start;
+    cs->wait_spin_limit = wined3d_cs_adapt_spin_limit(cs->wait_spin_limit,
+            WINED3D_CS_WAIT_SPIN_COUNT, spin_count, FALSE);
+}
+
 static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined3d_cs *cs)
 {
     struct wined3d_cs_packet *packet;
@@ -3243,6 +3300,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    BOOL stalled = FALSE;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
@@ -3293,6 +3351,12 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
 
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
+        if (!stalled)
+        {
+            ++cs->wait_stats.queue_full_stalls;
+            stalled = TRUE;
+        }
+        wined3d_cs_queue_wait_tail(cs, queue, tail, &queue->space_waiters);
     }
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
@@ -3314,12 +3378,14 @@ static void *wined3d_cs_mt_require_space(struct wined3d_device_context *context,
 static void wined3d_cs_mt_finish(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
+    struct wined3d_cs_queue *queue = &cs->queue[queue_id];
+    LONG tail;
 
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(context, queue_id);
 
-    while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
-        YieldProcessor();
+    while ((tail = *(volatile LONG *)&queue->tail) != queue->head)
+        wined3d_cs_queue_wait_tail(cs, queue, tail, &queue->empty_waiters);
 }
 
 static const struct wined3d_device_context_ops wined3d_cs_mt_ops =
@@ -3391,9 +3457,12 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
     struct wined3d_cs_queue *queue;
     unsigned int spin_count = 0;
     struct wined3d_cs *cs = ctx;
+    ULONG64 spin_start = 0;
     enum wined3d_cs_op opcode;
     HMODULE wined3d_module;
     unsigned int poll = 0;
+    BOOL slept = FALSE;
+    LONG *queue_tail;
     SIZE_T tail;
 
     TRACE("Started.\n");
@@ -3420,12 +3489,34 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
-                if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
+                if (!spin_count++)
+                    spin_start = wined3d_cs_get_ticks();
+                if (spin_count >= cs->idle_spin_limit && list_empty(&cs->query_poll_list))
+                {
+                    if (!slept)
+                    {
+                        cs->wait_stats.idle_spin_ticks += wined3d_cs_get_ticks() - spin_start;
+                        cs->idle_spin_limit = wined3d_cs_adapt_spin_limit(cs->idle_spin_limit,
+                                WINED3D_CS_SPIN_COUNT, spin_count, TRUE);
+                        slept = TRUE;
+                    }
+                    ++cs->wait_stats.idle_sleeps;
                     wined3d_cs_wait_event(cs);
+                }
                 continue;
             }
         }
-        spin_count = 0;
+        if (spin_count)
+        {
+            if (!slept)
+            {
+                cs->wait_stats.idle_spin_ticks += wined3d_cs_get_ticks() - spin_start;
+                cs->idle_spin_limit = wined3d_cs_adapt_spin_limit(cs->idle_spin_limit,
+                        WINED3D_CS_SPIN_COUNT, spin_count, FALSE);
+            }
+            spin_count = 0;
+            slept = FALSE;
+        }
 
         tail = queue->tail;
         packet = wined3d_next_cs_packet(queue->data, &tail);
@@ -3449,10 +3540,17 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
 
         tail &= (WINED3D_CS_QUEUE_SIZE - 1);
         InterlockedExchange(&queue->tail, tail);
+        if (*(volatile LONG *)&queue->space_waiters || (*(volatile LONG *)&queue->empty_waiters
+                && (LONG)tail == *(volatile LONG *)&queue->head))
+            RtlWakeAddressAll(&queue->tail);
     }
 
-    cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
-    cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail = cs->queue[WINED3D_CS_QUEUE_DEFAULT].head;
+    InterlockedExchange(&cs->queue[WINED3D_CS_QUEUE_MAP].tail, cs->queue[WINED3D_CS_QUEUE_MAP].head);
+    /* "cs" may be freed as soon as the default queue is empty, so only
+     * remember the address of its tail. */
+    queue_tail = &cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail;
+    InterlockedExchange(queue_tail, cs->queue[WINED3D_CS_QUEUE_DEFAULT].head);
+    RtlWakeAddressAll(queue_tail);
     TRACE("Stopped.\n");
     FreeLibraryAndExitThread(wined3d_module, 0);
 }
@@ -3489,6 +3587,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
             && !RtlIsCriticalSectionLockedByThread(NtCurrentTeb()->Peb->LoaderLock))
     {
         cs->c.ops = &wined3d_cs_mt_ops;
+        cs->idle_spin_limit = WINED3D_CS_SPIN_COUNT;
+        cs->wait_spin_limit = WINED3D_CS_WAIT_SPIN_COUNT;
 
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
@@ -3533,6 +3633,20 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
             ERR("Closing event failed.\n");
+
+        if (TRACE_ON(d3d_perf))
+        {
+            const struct wined3d_cs_wait_stats *stats = &cs->wait_stats;
+            LARGE_INTEGER frequency;
+
+            QueryPerformanceFrequency(&frequency);
+            TRACE_(d3d_perf)("CS thread: spun for %.3f ms, slept %u times, final spin limit %u.\n",
+                    stats->idle_spin_ticks * 1000.0 / frequency.QuadPart, stats->idle_sleeps, cs->idle_spin_limit);
+            TRACE_(d3d_perf)("Submitting threads: spun for %.3f ms, slept %u times, "
+                    "stalled on a full queue %u times, final spin limit %u.\n",
+                    stats->wait_spin_ticks * 1000.0 / frequency.QuadPart, stats->wait_sleeps,
+                    stats->queue_full_stalls, cs->wait_spin_limit);
+        }
     }
 
     wined3d_state_destroy(cs->c.state);
@@ -3969,6 +4083,174 @@ void CDECL wined3d_deferred_context_destroy(struct wined3d_device_context *conte
     heap_free(deferred);
 }
 
+struct wined3d_cs_state_key
+{
+    enum wined3d_cs_op opcode;
+    unsigned int type;
+    unsigned int start_idx;
+    unsigned int count;
+};
+
+/* Returns whether "packet" only replaces the state identified by "key",
+ * without side effects beyond invalidating that state, so that it can be
+ * dropped when another packet with the same key follows before anything
+ * consumes the state. */
+static bool wined3d_cs_packet_get_state_key(const struct wined3d_cs_packet *packet,
+        struct wined3d_cs_state_key *key)
+{
+    enum wined3d_cs_op opcode = *(const enum wined3d_cs_op *)packet->data;
+
+    memset(key, 0, sizeof(*key));
+    key->opcode = opcode;
+
+    switch (opcode)
+    {
+        case WINED3D_CS_OP_SET_VIEWPORTS:
+        case WINED3D_CS_OP_SET_SCISSOR_RECTS:
+        case WINED3D_CS_OP_SET_VERTEX_DECLARATION:
+        case WINED3D_CS_OP_SET_INDEX_BUFFER:
+        case WINED3D_CS_OP_SET_BLEND_STATE:
+        case WINED3D_CS_OP_SET_DEPTH_STENCIL_STATE:
+        case WINED3D_CS_OP_SET_RASTERIZER_STATE:
+            return true;
+
+        case WINED3D_CS_OP_SET_RENDERTARGET_VIEWS:
+        {
+            const struct wined3d_cs_set_rendertarget_views *op = (const void *)packet->data;
+
+            key->start_idx = op->start_idx;
+            key->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_STREAM_SOURCES:
+        {
+            const struct wined3d_cs_set_stream_sources *op = (const void *)packet->data;
+
+            key->start_idx = op->start_idx;
+            key->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_CONSTANT_BUFFERS:
+        {
+            const struct wined3d_cs_set_constant_buffers *op = (const void *)packet->data;
+
+            key->type = op->type;
+            key->start_idx = op->start_idx;
+            key->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_SHADER_RESOURCE_VIEWS:
+        {
+            const struct wined3d_cs_set_shader_resource_views *op = (const void *)packet->data;
+
+            key->type = op->type;
+            key->start_idx = op->start_idx;
+            key->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_SAMPLERS:
+        {
+            const struct wined3d_cs_set_samplers *op = (const void *)packet->data;
+
+            key->type = op->type;
+            key->start_idx = op->start_idx;
+            key->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_SHADER:
+        {
+            const struct wined3d_cs_set_shader *op = (const void *)packet->data;
+
+            key->type = op->type;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+/* Command lists are executed serially on the CS thread, but recorded on
+ * application threads. Drop state changes that are overridden before any
+ * command uses them while we're still on the recording thread, so that the
+ * CS thread doesn't have to apply and invalidate them during execution. */
+static void wined3d_deferred_context_prune_state(struct wined3d_deferred_context *deferred)
+{
+    struct
+    {
+        struct wined3d_cs_state_key key;
+        SIZE_T offset;
+    } pending[32];
+    SIZE_T offset = 0, packet_offset, new_size = 0, size;
+    struct wined3d_cs_state_key key;
+    unsigned int pending_count = 0;
+    struct wined3d_cs_packet *packet;
+    unsigned int i, dropped = 0;
+    BYTE *data = deferred->data;
+
+    while (offset < deferred->data_size)
+    {
+        packet_offset = offset;
+        packet = wined3d_next_cs_packet(data, &offset);
+
+        if (*(const enum wined3d_cs_op *)packet->data == WINED3D_CS_OP_NOP)
+            continue;
+
+        if (!wined3d_cs_packet_get_state_key(packet, &key))
+        {
+            pending_count = 0;
+            continue;
+        }
+
+        for (i = 0; i < pending_count; ++i)
+        {
+            if (!memcmp(&pending[i].key, &key, sizeof(key)))
+                break;
+        }
+
+        if (i < pending_count)
+        {
+            struct wined3d_cs_packet *prev = (struct wined3d_cs_packet *)&data[pending[i].offset];
+
+            wined3d_cs_packet_decref_objects(prev);
+            *(enum wined3d_cs_op *)prev->data = WINED3D_CS_OP_NOP;
+            pending[i].offset = packet_offset;
+            ++dropped;
+        }
+        else if (pending_count < ARRAY_SIZE(pending))
+        {
+            pending[pending_count].key = key;
+            pending[pending_count++].offset = packet_offset;
+        }
+    }
+
+    if (!dropped)
+        return;
+
+    offset = 0;
+    while (offset < deferred->data_size)
+    {
+        packet_offset = offset;
+        packet = wined3d_next_cs_packet(data, &offset);
+        if (*(const enum wined3d_cs_op *)packet->data == WINED3D_CS_OP_NOP)
+            continue;
+
+        size = offset - packet_offset;
+        if (new_size != packet_offset)
+            memmove(&data[new_size], packet, size);
+        new_size += size;
+    }
+
+    TRACE("Dropped %u redundant state packets, %lu bytes.\n",
+            dropped, (unsigned long)(deferred->data_size - new_size));
+    deferred->data_size = new_size;
+}
+
 HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device_context *context,
         bool restore, struct wined3d_command_list **list)
 {
@@ -3979,6 +4261,7 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     TRACE("context %p, list %p.\n", context, list);
 
     wined3d_device_context_lock(context);
+    wined3d_deferred_context_prune_state(deferred);
     memory = heap_alloc(sizeof(*object) + deferred->resource_count * sizeof(*object->resources)
             + deferred->upload_count * sizeof(*object->uploads)
             + deferred->command_list_count * sizeof(*object->command_lists)
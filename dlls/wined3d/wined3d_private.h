@@ -497,6 +497,7 @@ struct wined3d_settings
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
     BOOL cb_access_map_w;
+    char *vk_pipeline_cache;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -3508,6 +3509,9 @@ struct wined3d_adapter_vk
 
     VkPhysicalDeviceLimits device_limits;
     VkPhysicalDeviceMemoryProperties memory_properties;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
 };
 
 static inline struct wined3d_adapter_vk *wined3d_adapter_vk(struct wined3d_adapter *adapter)
@@ -4106,6 +4110,7 @@ struct wined3d_device_vk
     uint32_t timestamp_bits;
 
     struct wined3d_vk_info vk_info;
+    VkPipelineCache vk_pipeline_cache;
 
     struct wined3d_null_resources_vk null_resources_vk;
     struct wined3d_null_views_vk null_views_vk;
@@ -4849,13 +4854,29 @@ enum wined3d_push_constants
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_SPIN_COUNT_MIN       1000u
+#define WINED3D_CS_WAIT_SPIN_COUNT      100000u
 
 struct wined3d_cs_queue
 {
     LONG head, tail;
+    LONG empty_waiters, space_waiters;
     BYTE data[WINED3D_CS_QUEUE_SIZE];
 };
 
+/* Wait statistics of a multithreaded command stream, dumped on the
+ * d3d_perf channel when the device is destroyed. */
+struct wined3d_cs_wait_stats
+{
+    /* Command stream thread, waiting for commands. */
+    ULONG64 idle_spin_ticks;
+    unsigned int idle_sleeps;
+    /* Submitting threads, waiting for the command stream thread. */
+    ULONG64 wait_spin_ticks;
+    unsigned int wait_sleeps;
+    unsigned int queue_full_stalls;
+};
+
 struct wined3d_device_context_ops
 {
     void *(*require_space)(struct wined3d_device_context *context, size_t size, enum wined3d_cs_queue_id queue_id);
@@ -4905,6 +4926,10 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    unsigned int idle_spin_limit;
+    unsigned int wait_spin_limit;
+    struct wined3d_cs_wait_stats wait_stats;
 };
 
 static inline void wined3d_device_context_lock(struct wined3d_device_context *context)
@@ -377,14 +377,26 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    struct list           entry;      /* entry in expired timeouts list */
+    int                   index;      /* index in timeout heap, -1 if expired */
     abstime_t             when;       /* timeout expiry */
+    timeout_t             key;        /* expiry in the heap time base, lower fires first */
+    unsigned int          seq;        /* insertion sequence, to keep ordering stable */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list abs_timeout_list = LIST_INIT(abs_timeout_list); /* sorted absolute timeouts list */
-static struct list rel_timeout_list = LIST_INIT(rel_timeout_list); /* sorted relative timeouts list */
+/* binary min-heap of timeouts, ordered by key */
+struct timeout_heap
+{
+    struct timeout_user **users;      /* heap array */
+    int                   count;      /* number of timeouts in the heap */
+    int                   size;       /* allocated size of the heap array */
+};
+
+static struct timeout_heap abs_timeout_heap;  /* absolute timeouts, keyed on current_time */
+static struct timeout_heap rel_timeout_heap;  /* relative timeouts, keyed on monotonic_time */
+static unsigned int timeout_seq;
 timeout_t current_time;
 timeout_t monotonic_time;
 
@@ -461,43 +473,112 @@ void set_current_time(void)
     if (user_shared_data) set_user_shared_data_time();
 }
 
+/* check if timeout a must fire before timeout b */
+static inline int timeout_before( const struct timeout_user *a, const struct timeout_user *b )
+{
+    if (a->key != b->key) return a->key < b->key;
+    return (int)(a->seq - b->seq) > 0;  /* most recently added first, as with the old sorted lists */
+}
+
+static inline void timeout_heap_set( struct timeout_heap *heap, int index, struct timeout_user *user )
+{
+    heap->users[index] = user;
+    user->index = index;
+}
+
+static void timeout_heap_sift_up( struct timeout_heap *heap, int index )
+{
+    struct timeout_user *user = heap->users[index];
+
+    while (index)
+    {
+        int parent = (index - 1) / 2;
+        if (!timeout_before( user, heap->users[parent] )) break;
+        timeout_heap_set( heap, index, heap->users[parent] );
+        index = parent;
+    }
+    timeout_heap_set( heap, index, user );
+}
+
+static void timeout_heap_sift_down( struct timeout_heap *heap, int index )
+{
+    struct timeout_user *user = heap->users[index];
+
+    for (;;)
+    {
+        int child = 2 * index + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && timeout_before( heap->users[child + 1], heap->users[child] )) child++;
+        if (!timeout_before( heap->users[child], user )) break;
+        timeout_heap_set( heap, index, heap->users[child] );
+        index = child;
+    }
+    timeout_heap_set( heap, index, user );
+}
+
+static int timeout_heap_insert( struct timeout_heap *heap, struct timeout_user *user )
+{
+    if (heap->count == heap->size)
+    {
+        int new_size = max( heap->size * 2, 64 );
+        struct timeout_user **new_users = realloc( heap->users, new_size * sizeof(*new_users) );
+
+        if (!new_users)
+        {
+            set_error( STATUS_NO_MEMORY );
+            return 0;
+        }
+        heap->users = new_users;
+        heap->size = new_size;
+    }
+    timeout_heap_set( heap, heap->count++, user );
+    timeout_heap_sift_up( heap, user->index );
+    return 1;
+}
+
+static void timeout_heap_remove( struct timeout_heap *heap, struct timeout_user *user )
+{
+    int index = user->index;
+    struct timeout_user *last = heap->users[--heap->count];
+
+    user->index = -1;
+    if (last == user) return;
+    timeout_heap_set( heap, index, last );
+    if (index && timeout_before( last, heap->users[(index - 1) / 2] )) timeout_heap_sift_up( heap, index );
+    else timeout_heap_sift_down( heap, index );
+}
+
+static inline struct timeout_user *timeout_heap_head( const struct timeout_heap *heap )
+{
+    return heap->count ? heap->users[0] : NULL;
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
 
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = timeout_to_abstime( when );
+    user->seq      = timeout_seq++;
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
-
-    if (user->when > 0)
+    /* absolute timeouts are keyed on current_time, relative ones on monotonic_time */
+    user->key = user->when > 0 ? user->when : -user->when;
+    if (!timeout_heap_insert( user->when > 0 ? &abs_timeout_heap : &rel_timeout_heap, user ))
     {
-        LIST_FOR_EACH( ptr, &abs_timeout_list )
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when >= user->when) break;
-        }
-    }
-    else
-    {
-        LIST_FOR_EACH( ptr, &rel_timeout_list )
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when <= user->when) break;
-        }
+        free( user );
+        return NULL;
     }
-    list_add_before( ptr, &user->entry );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->index == -1) list_remove( &user->entry );  /* expired but callback not called yet */
+    else timeout_heap_remove( user->when > 0 ? &abs_timeout_heap : &rel_timeout_heap, user );
     free( user );
 }
 
@@ -932,59 +1013,46 @@ static int get_next_timeout(void)
 {
     int ret = user_shared_data ? user_shared_data_timeout : -1;
 
-    if (!list_empty( &abs_timeout_list ) || !list_empty( &rel_timeout_list ))
+    if (abs_timeout_heap.count || rel_timeout_heap.count)
     {
+        struct timeout_user *timeout;
         struct list expired_list, *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heaps */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &abs_timeout_list )) != NULL)
+        while ((timeout = timeout_heap_head( &abs_timeout_heap )) && timeout->key <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            timeout_heap_remove( &abs_timeout_heap, timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
-        while ((ptr = list_head( &rel_timeout_list )) != NULL)
+        while ((timeout = timeout_heap_head( &rel_timeout_heap )) && timeout->key <= monotonic_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (-timeout->when <= monotonic_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            timeout_heap_remove( &rel_timeout_heap, timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
 
         while ((ptr = list_head( &expired_list )) != NULL)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
             list_remove( &timeout->entry );
             timeout->callback( timeout->private );
             free( timeout );
         }
 
-        if ((ptr = list_head( &abs_timeout_list )) != NULL)
+        if ((timeout = timeout_heap_head( &abs_timeout_heap )))
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            timeout_t diff = (timeout->when - current_time + 9999) / 10000;
+            timeout_t diff = (timeout->key - current_time + 9999) / 10000;
             if (diff > INT_MAX) diff = INT_MAX;
             else if (diff < 0) diff = 0;
             if (ret == -1 || diff < ret) ret = diff;
         }
 
-        if ((ptr = list_head( &rel_timeout_list )) != NULL)
+        if ((timeout = timeout_heap_head( &rel_timeout_heap )))
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            timeout_t diff = (-timeout->when - monotonic_time + 9999) / 10000;
+            timeout_t diff = (timeout->key - monotonic_time + 9999) / 10000;
             if (diff > INT_MAX) diff = INT_MAX;
             else if (diff < 0) diff = 0;
             if (ret == -1 || diff < ret) ret = diff;
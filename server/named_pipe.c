@@ -538,7 +538,7 @@ static void named_pipe_device_destroy( struct object *obj )
 {
     struct named_pipe_device *device = (struct named_pipe_device*)obj;
     assert( obj->ops == &named_pipe_device_ops );
-    free( device->pipes );
+    free_namespace( device->pipes );
 }
 
 struct object *create_named_pipe_device( struct object *root, const struct unicode_str *name,
@@ -807,9 +807,13 @@ static void message_queue_read( struct pipe_end *pipe_end, struct async *async )
     }
 
     message = LIST_ENTRY( list_head(&pipe_end->message_queue), struct pipe_message, entry );
-    if (!message->read_pos && message->iosb->in_size == iosb->out_size) /* fast path */
+    if (message->iosb->in_size - message->read_pos == out_size) /* fast path */
     {
-        async_request_complete( async, status, out_size, out_size, message->iosb->in_data );
+        /* the read consumes the rest of the first message, hand its buffer over */
+        char *data = message->iosb->in_data;
+
+        if (message->read_pos) memmove( data, data + message->read_pos, out_size );
+        async_request_complete( async, status, out_size, out_size, data );
         message->iosb->in_data = NULL;
         wake_message( message, message->iosb->in_size );
         free_message( message );
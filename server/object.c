@@ -46,9 +46,13 @@
 struct namespace
 {
     unsigned int        hash_size;       /* size of hash table */
-    struct list         names[1];        /* array of hash entry lists */
+    unsigned int        count;           /* number of names in the table */
+    struct list        *names;           /* array of hash entry lists */
 };
 
+#define MAX_NAMESPACE_LOAD     4         /* average entries per bucket before growing */
+#define MAX_NAMESPACE_HASH_SIZE 0x100000 /* don't grow the hash table past this size */
+
 
 struct type_descr no_type =
 {
@@ -134,11 +138,44 @@ void *memdup( const void *data, size_t len )
 
 /*****************************************************************/
 
+/* grow the namespace hash table and redistribute the names, using their cached hash values */
+static void grow_namespace( struct namespace *namespace )
+{
+    unsigned int i, new_size = namespace->hash_size * 2 + 1;
+    struct object_name *ptr, *next;
+    struct list *new_names;
+
+    if (!(new_names = malloc( new_size * sizeof(*new_names) ))) return;  /* keep the old table */
+    for (i = 0; i < new_size; i++) list_init( &new_names[i] );
+
+    for (i = 0; i < namespace->hash_size; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( ptr, next, &namespace->names[i], struct object_name, entry )
+        {
+            list_remove( &ptr->entry );
+            list_add_tail( &new_names[ptr->hash % new_size], &ptr->entry );
+        }
+    }
+    free( namespace->names );
+    namespace->names = new_names;
+    namespace->hash_size = new_size;
+}
+
 void namespace_add( struct namespace *namespace, struct object_name *ptr )
 {
-    unsigned int hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
+    if (namespace->count >= namespace->hash_size * MAX_NAMESPACE_LOAD &&
+        namespace->hash_size < MAX_NAMESPACE_HASH_SIZE)
+        grow_namespace( namespace );
 
-    list_add_head( &namespace->names[hash], &ptr->entry );
+    ptr->namespace = namespace;
+    list_add_head( &namespace->names[ptr->hash % namespace->hash_size], &ptr->entry );
+    namespace->count++;
+}
+
+static void namespace_remove( struct object_name *ptr )
+{
+    list_remove( &ptr->entry );
+    if (ptr->namespace) ptr->namespace->count--;
 }
 
 /* allocate a name for an object */
@@ -149,7 +186,9 @@ static struct object_name *alloc_name( const struct unicode_str *name )
     if ((ptr = mem_alloc( sizeof(*ptr) + name->len - sizeof(ptr->name) )))
     {
         ptr->len = name->len;
+        ptr->hash = get_hash_strW( name->str, name->len );
         ptr->parent = NULL;
+        ptr->namespace = NULL;
         memcpy( ptr->name, name->str, name->len );
     }
     return ptr;
@@ -448,15 +487,17 @@ struct object *find_object( const struct namespace *namespace, const struct unic
                             unsigned int attributes )
 {
     const struct list *list;
+    unsigned int hash;
     struct list *p;
 
     if (!name || !name->len) return NULL;
 
-    list = &namespace->names[ hash_strW( name->str, name->len, namespace->hash_size ) ];
+    hash = get_hash_strW( name->str, name->len );
+    list = &namespace->names[hash % namespace->hash_size];
     LIST_FOR_EACH( p, list )
     {
         const struct object_name *ptr = LIST_ENTRY( p, struct object_name, entry );
-        if (ptr->len != name->len) continue;
+        if (ptr->hash != hash || ptr->len != name->len) continue;
         if (attributes & OBJ_CASE_INSENSITIVE)
         {
             if (!memicmp_strW( ptr->name, name->str, name->len ))
@@ -495,15 +536,27 @@ struct namespace *create_namespace( unsigned int hash_size )
     struct namespace *namespace;
     unsigned int i;
 
-    namespace = mem_alloc( sizeof(*namespace) + (hash_size - 1) * sizeof(namespace->names[0]) );
-    if (namespace)
+    if (!(namespace = mem_alloc( sizeof(*namespace) ))) return NULL;
+    if (!(namespace->names = mem_alloc( hash_size * sizeof(namespace->names[0]) )))
     {
-        namespace->hash_size      = hash_size;
-        for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
+        free( namespace );
+        return NULL;
     }
+    namespace->hash_size      = hash_size;
+    namespace->count          = 0;
+    for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
     return namespace;
 }
 
+/* free a namespace; it must not contain any names anymore */
+void free_namespace( struct namespace *namespace )
+{
+    if (!namespace) return;
+    assert( !namespace->count );
+    free( namespace->names );
+    free( namespace );
+}
+
 /* functions for unimplemented/default object operations */
 
 int no_add_queue( struct object *obj, struct wait_queue_entry *entry )
@@ -690,7 +743,7 @@ int no_link_name( struct object *obj, struct object_name *name, struct object *p
 
 void default_unlink_name( struct object *obj, struct object_name *name )
 {
-    list_remove( &name->entry );
+    namespace_remove( name );
 }
 
 struct object *no_open_file( struct object *obj, unsigned int access, unsigned int sharing,
@@ -132,6 +132,8 @@ struct object_name
     struct list         entry;           /* entry in the hash list */
     struct object      *obj;             /* object owning this name */
     struct object      *parent;          /* parent object */
+    struct namespace   *namespace;       /* namespace containing the name */
+    unsigned int        hash;            /* case-insensitive hash of the name */
     data_size_t         len;             /* name length in bytes */
     WCHAR               name[1];
 };
@@ -160,6 +162,7 @@ extern void *open_named_object( struct object *parent, const struct object_ops *
                                 const struct unicode_str *name, unsigned int attributes );
 extern void unlink_named_object( struct object *obj );
 extern struct namespace *create_namespace( unsigned int hash_size );
+extern void free_namespace( struct namespace *namespace );
 extern void free_kernel_objects( struct object *obj );
 /* grab/release_object can take any pointer, but you better make sure */
 /* that the thing pointed to starts with a struct object... */
@@ -243,6 +246,7 @@ extern unsigned int supported_machines_count;
 extern unsigned short supported_machines[8];
 extern unsigned short native_machine;
 extern void init_registry(void);
+extern void init_registry_shared_memory( struct object *root, const struct unicode_str *name );
 extern void flush_registry(void);
 
 static inline int is_machine_32bit( unsigned short machine )
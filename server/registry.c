@@ -89,6 +89,10 @@ struct key
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
+    struct name_index *subkey_index; /* hash index of subkeys for large keys */
+    struct name_index *value_index;  /* hash index of values for large keys */
+    unsigned int      shared_id;   /* id of the key in the shared memory, 0 if not published */
+    unsigned int      query_count; /* number of value queries, to decide when to publish the key */
     unsigned int      flags;       /* flags */
     timeout_t         modif;       /* last modification time */
     struct list       notify_list; /* list of notifications */
@@ -102,6 +106,9 @@ struct key
 #define KEY_WOW64    0x0010  /* key contains a Wow6432Node subkey */
 #define KEY_WOWSHARE 0x0020  /* key is a Wow64 shared key (used for Software\Classes) */
 #define KEY_PREDEF   0x0040  /* key is marked as predefined */
+#define KEY_CHANGED  0x0080  /* key itself has been modified since the last save */
+#define KEY_SUBKEYS_UNSORTED 0x0100  /* subkeys array needs sorting, only with a subkey index */
+#define KEY_VALUES_UNSORTED  0x0200  /* values array needs sorting, only with a value index */
 
 /* a key value */
 struct key_value
@@ -115,6 +122,15 @@ struct key_value
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
+#define MIN_INDEXED  64  /* min. number of subkeys or values to use a hash index */
+
+/* case-insensitive hash index of the subkeys or values of a large key */
+/* without an index, the arrays are kept sorted and searched with a binary search */
+struct name_index
+{
+    unsigned int size;         /* number of buckets, a power of 2 */
+    int          entries[1];   /* position in the subkeys or values array, -1 if free */
+};
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
@@ -134,18 +150,55 @@ static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_va
 
 static void set_periodic_save_timer(void);
 static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
+static void sort_subkeys( struct key *key );
+static void sort_values( struct key *key );
+
+/* a key deleted since the last save of its branch */
+struct deleted_key
+{
+    struct list  entry;
+    data_size_t  len;           /* length of the path relative to the branch */
+    WCHAR        path[1];       /* path relative to the branch key */
+};
 
 /* information about where to save a registry branch */
 struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    char        *journal_path;  /* file where changes are appended between full saves */
+    unsigned int journal_id;    /* id matching the saved file and its journal, 0 to force a full save */
+    off_t        file_size;     /* size of the last full save */
+    off_t        journal_size;  /* current size of the journal */
+    struct list  deleted_keys;  /* keys deleted since the last save */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
 static int save_branch_count;
 static struct save_branch_info save_branch_info[MAX_SAVE_BRANCH_INFO];
 
+/* values of frequently queried keys are published in shared memory, */
+/* so that clients can read them without a server round trip */
+#define SHARED_QUERY_THRESHOLD 16  /* number of value queries before a key is published */
+
+/* only keys in these subtrees are published */
+static const char * const shared_subtrees[] =
+{
+    "Machine\\Software\\Classes",
+    "Machine\\Software\\Microsoft\\Windows\\CurrentVersion",
+    "Machine\\Software\\Microsoft\\Windows NT\\CurrentVersion",
+    "Machine\\Software\\Wow6432Node\\Microsoft\\Windows\\CurrentVersion",
+    "Machine\\Software\\Wow6432Node\\Microsoft\\Windows NT\\CurrentVersion",
+    "Machine\\System\\ControlSet001\\Control",
+};
+static struct unicode_str shared_subtree_names[ARRAY_SIZE(shared_subtrees)];
+
+static struct object *registry_shared_mapping;
+static volatile struct registry_shared_memory *registry_shared;
+static struct key *shared_keys[REGISTRY_SHARED_SLOTS];  /* key published in each slot */
+static unsigned int shared_next_slot;     /* next slot to reuse */
+static unsigned int shared_generation;    /* generation counter for the key ids */
+
 unsigned int supported_machines_count = 0;
 unsigned short supported_machines[8];
 unsigned short native_machine = 0;
@@ -160,12 +213,15 @@ struct file_load_info
     int         line;     /* current input line */
     WCHAR      *tmp;      /* temp buffer to use while parsing input */
     size_t      tmplen;   /* length of temp buffer */
+    unsigned int journal_id; /* journal id found in the file header */
 };
 
 
 static void key_dump( struct object *obj, int verbose );
 static unsigned int key_map_access( struct object *obj, unsigned int access );
 static struct security_descriptor *key_get_sd( struct object *obj );
+static int key_set_sd( struct object *obj, const struct security_descriptor *sd,
+                       unsigned int set_info );
 static WCHAR *key_get_full_name( struct object *obj, data_size_t *len );
 static int key_close_handle( struct object *obj, struct process *process, obj_handle_t handle );
 static void key_destroy( struct object *obj );
@@ -185,7 +241,7 @@ static const struct object_ops key_ops =
     no_get_fd,               /* get_fd */
     key_map_access,          /* map_access */
     key_get_sd,              /* get_sd */
-    default_set_sd,          /* set_sd */
+    key_set_sd,              /* set_sd */
     key_get_full_name,       /* get_full_name */
     no_lookup_name,          /* lookup_name */
     no_link_name,            /* link_name */
@@ -276,32 +332,53 @@ static void dump_value( const struct key_value *value, FILE *f )
     fputc( '\n', f );
 }
 
+/* save a key with its options and values to a text file */
+static void save_key( const struct key *key, const struct key *base, FILE *f, int clear )
+{
+    int i;
+
+    fprintf( f, "\n[" );
+    if (key != base) dump_path( key, base, f );
+    fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
+    if (clear) fputs( "#clear\n", f );
+    fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
+    if (key->class)
+    {
+        fprintf( f, "#class=\"" );
+        dump_strW( key->class, key->classlen, f, "\"\"" );
+        fprintf( f, "\"\n" );
+    }
+    if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
+    for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
+}
+
 /* save a registry and all its subkeys to a text file */
-static void save_subkeys( const struct key *key, const struct key *base, FILE *f )
+static void save_subkeys( struct key *key, const struct key *base, FILE *f )
 {
     int i;
 
     if (key->flags & KEY_VOLATILE) return;
+    sort_subkeys( key );
+    sort_values( key );
     /* save key if it has either some values or no subkeys, or needs special options */
     /* keys with no values but subkeys are saved implicitly by saving the subkeys */
     if ((key->last_value >= 0) || (key->last_subkey == -1) || key->class || (key->flags & KEY_SYMLINK))
-    {
-        fprintf( f, "\n[" );
-        if (key != base) dump_path( key, base, f );
-        fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
-        fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
-        if (key->class)
-        {
-            fprintf( f, "#class=\"" );
-            dump_strW( key->class, key->classlen, f, "\"\"" );
-            fprintf( f, "\"\n" );
-        }
-        if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
-        for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
-    }
+        save_key( key, base, f, 0 );
     for (i = 0; i <= key->last_subkey; i++) save_subkeys( key->subkeys[i], base, f );
 }
 
+/* save the keys modified since the last save to a journal file */
+static void save_changed_subkeys( const struct key *key, const struct key *base, FILE *f )
+{
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return;
+    if (!(key->flags & KEY_DIRTY)) return;  /* nothing modified in this subtree */
+    /* always save changed keys, and replace all their values when loading */
+    if (key->flags & KEY_CHANGED) save_key( key, base, f, 1 );
+    for (i = 0; i <= key->last_subkey; i++) save_changed_subkeys( key->subkeys[i], base, f );
+}
+
 static void dump_operation( const struct key *key, const struct key_value *value, const char *op )
 {
     fprintf( stderr, "%s key ", op );
@@ -429,12 +506,213 @@ static WCHAR *key_get_full_name( struct object *obj, data_size_t *ret_len )
     return (WCHAR *)ret;
 }
 
+/* size of a value in a shared memory slot */
+static inline data_size_t get_shared_value_size( const struct key_value *value )
+{
+    return (sizeof(struct registry_shared_value) + value->namelen + value->len + 3) & ~3;
+}
+
+/* size of all the values of a key in a shared memory slot */
+static data_size_t get_shared_key_size( const struct key *key )
+{
+    data_size_t size = 0;
+    int i;
+
+    for (i = 0; i <= key->last_value; i++) size += get_shared_value_size( &key->values[i] );
+    return size;
+}
+
+/* remove a key from the shared memory */
+static void unpublish_shared_key( struct key *key )
+{
+    unsigned int index = key->shared_id & (REGISTRY_SHARED_SLOTS - 1);
+    volatile struct registry_shared_slot *slot;
+
+    if (!key->shared_id) return;
+    slot = &registry_shared->slots[index];
+    SHARED_WRITE_BEGIN( &slot->seq );
+    slot->key_id = 0;
+    slot->count = 0;
+    slot->size = 0;
+    SHARED_WRITE_END( &slot->seq );
+    shared_keys[index] = NULL;
+    key->shared_id = 0;
+    /* make the key earn its slot again, so that evicted keys don't keep evicting each other */
+    key->query_count = 0;
+}
+
+/* copy the values of a published key to its shared memory slot */
+static void update_shared_key( struct key *key )
+{
+    volatile struct registry_shared_slot *slot;
+    struct registry_shared_value *shared_value;
+    unsigned char *ptr;
+    data_size_t size;
+    int i;
+
+    if (!key->shared_id) return;
+    if ((size = get_shared_key_size( key )) > REGISTRY_SHARED_SLOT_DATA)
+    {
+        unpublish_shared_key( key );
+        return;
+    }
+
+    slot = &registry_shared->slots[key->shared_id & (REGISTRY_SHARED_SLOTS - 1)];
+    SHARED_WRITE_BEGIN( &slot->seq );
+    slot->key_id = key->shared_id;
+    slot->count = key->last_value + 1;
+    slot->size = size;
+    ptr = (unsigned char *)slot->data;
+    for (i = 0; i <= key->last_value; i++)
+    {
+        shared_value = (struct registry_shared_value *)ptr;
+        shared_value->type = key->values[i].type;
+        shared_value->namelen = key->values[i].namelen;
+        shared_value->len = key->values[i].len;
+        memcpy( shared_value + 1, key->values[i].name, key->values[i].namelen );
+        if (key->values[i].len)
+            memcpy( (char *)(shared_value + 1) + key->values[i].namelen,
+                    key->values[i].data, key->values[i].len );
+        ptr += get_shared_value_size( &key->values[i] );
+    }
+    SHARED_WRITE_END( &slot->seq );
+}
+
+/* check that every token allowed to map the shared memory may query the values of the key */
+static int is_key_shareable( struct key *key )
+{
+    const struct security_descriptor *sd = key_get_sd( &key->obj );
+    const struct acl *dacl;
+    const struct ace *ace;
+    const struct sid *sid;
+    int i, present, allowed = 0;
+
+    /* a mandatory label could deny read access to some integrity levels */
+    if (sd->sacl_len) return 0;
+    dacl = sd_get_dacl( sd, &present );
+    if (!present || !dacl) return 1;
+
+    for (i = 0, ace = ace_first( dacl ); i < dacl->count; i++, ace = ace_next( ace ))
+    {
+        if (ace->flags & INHERIT_ONLY_ACE) continue;
+        /* a denied ace could apply to any group of the reading token */
+        if (ace->type != ACCESS_ALLOWED_ACE_TYPE) return 0;
+        sid = (const struct sid *)(ace + 1);
+        if (!equal_sid( sid, &builtin_admins_sid ) && !equal_sid( sid, &world_sid )) continue;
+        if (key_map_access( &key->obj, ace->mask ) & KEY_QUERY_VALUE) allowed = 1;
+    }
+    return allowed;
+}
+
+/* check if a key is in one of the subtrees whose keys may be published */
+static int is_key_in_shared_subtree( struct key *key )
+{
+    data_size_t len, prefix_len = sizeof(root_name);
+    WCHAR *name;
+    int i, ret = 0;
+
+    if (!(name = key_get_full_name( &key->obj, &len ))) return 0;
+    for (i = 0; i < ARRAY_SIZE(shared_subtree_names) && !ret; i++)
+    {
+        const struct unicode_str *subtree = &shared_subtree_names[i];
+
+        if (len < prefix_len + subtree->len) continue;
+        if (memicmp_strW( name + prefix_len / sizeof(WCHAR), subtree->str, subtree->len )) continue;
+        ret = (len == prefix_len + subtree->len ||
+               name[(prefix_len + subtree->len) / sizeof(WCHAR)] == '\\');
+    }
+    free( name );
+    return ret;
+}
+
+/* publish a key in the shared memory, replacing the oldest published key */
+static void publish_shared_key( struct key *key )
+{
+    unsigned int index;
+
+    if (!registry_shared || key->shared_id) return;
+    if (key->flags & (KEY_PREDEF | KEY_DELETED)) return;
+    if (!is_key_in_shared_subtree( key ) || !is_key_shareable( key ))
+    {
+        key->query_count = 0;
+        return;
+    }
+    /* don't evict another key for one that doesn't fit */
+    if (get_shared_key_size( key ) > REGISTRY_SHARED_SLOT_DATA)
+    {
+        key->query_count = 0;
+        return;
+    }
+
+    index = shared_next_slot++ % REGISTRY_SHARED_SLOTS;
+    if (shared_keys[index]) unpublish_shared_key( shared_keys[index] );
+    /* make sure that the ids of the successive keys in a slot are different and never 0 */
+    if (!(++shared_generation & ((1u << (32 - REGISTRY_SHARED_SLOT_BITS)) - 1))) shared_generation++;
+    key->shared_id = (shared_generation << REGISTRY_SHARED_SLOT_BITS) | index;
+    shared_keys[index] = key;
+    update_shared_key( key );
+}
+
+/* create the shared memory used to publish the values of frequently queried keys */
+void init_registry_shared_memory( struct object *root, const struct unicode_str *name )
+{
+    struct security_descriptor *sd;
+    struct acl *dacl;
+    size_t admins_sid_len = sid_len( &builtin_admins_sid );
+    size_t dacl_len = sizeof(*dacl) + sizeof(struct ace) + admins_sid_len;
+    struct sid *sid;
+    void *ptr;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(shared_subtrees); i++)
+        if (!ascii_to_unicode_str( shared_subtrees[i], &shared_subtree_names[i] )) return;
+
+    /* only administrators may map it, published keys must be readable by them (see is_key_shareable) */
+    if (!(sd = mem_alloc( sizeof(*sd) + 2 * admins_sid_len + dacl_len ))) return;
+    sd->control   = SE_DACL_PRESENT;
+    sd->owner_len = admins_sid_len;
+    sd->group_len = admins_sid_len;
+    sd->sacl_len  = 0;
+    sd->dacl_len  = dacl_len;
+    sid = (struct sid *)(sd + 1);
+    sid = copy_sid( sid, &builtin_admins_sid );
+    sid = copy_sid( sid, &builtin_admins_sid );
+
+    dacl = (struct acl *)((char *)(sd + 1) + 2 * admins_sid_len);
+    dacl->revision = ACL_REVISION;
+    dacl->pad1     = 0;
+    dacl->size     = dacl_len;
+    dacl->count    = 1;
+    dacl->pad2     = 0;
+    set_ace( ace_first( dacl ), &builtin_admins_sid, ACCESS_ALLOWED_ACE_TYPE, 0,
+             SECTION_QUERY | SECTION_MAP_READ );
+
+    registry_shared_mapping = create_shared_mapping( root, name, sizeof(*registry_shared), sd, &ptr );
+    free( sd );
+    if (!registry_shared_mapping) return;
+    memset( ptr, 0, sizeof(*registry_shared) );
+    registry_shared = ptr;
+}
+
+static int key_set_sd( struct object *obj, const struct security_descriptor *sd,
+                       unsigned int set_info )
+{
+    struct key *key = (struct key *)obj;
+
+    if (!default_set_sd( obj, sd, set_info )) return 0;
+    /* the new security descriptor may no longer allow publishing the values */
+    unpublish_shared_key( key );
+    return 1;
+}
+
 /* close the notification associated with a handle */
 static int key_close_handle( struct object *obj, struct process *process, obj_handle_t handle )
 {
     struct key * key = (struct key *) obj;
     struct notify *notify = find_notify( key, process, handle );
     if (notify) do_notification( key, notify, 1 );
+    /* the owning process can't tell that its cached key ids are stale, the value may be reused */
+    if (registry_shared && (!current || process != current->process)) registry_shared->close_serial++;
     return 1;  /* ok to close */
 }
 
@@ -445,6 +723,7 @@ static void key_destroy( struct object *obj )
     struct key *key = (struct key *)obj;
     assert( obj->ops == &key_ops );
 
+    unpublish_shared_key( key );
     free( key->name );
     free( key->class );
     for (i = 0; i <= key->last_value; i++)
@@ -453,12 +732,14 @@ static void key_destroy( struct object *obj )
         free( key->values[i].data );
     }
     free( key->values );
+    free( key->value_index );
     for (i = 0; i <= key->last_subkey; i++)
     {
         key->subkeys[i]->parent = NULL;
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_index );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -524,6 +805,10 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->nb_values   = 0;
         key->last_value  = -1;
         key->values      = NULL;
+        key->subkey_index = NULL;
+        key->value_index = NULL;
+        key->shared_id   = 0;
+        key->query_count = 0;
         key->modif       = modif;
         key->parent      = NULL;
         list_init( &key->notify_list );
@@ -554,7 +839,7 @@ static void make_clean( struct key *key )
 
     if (key->flags & KEY_VOLATILE) return;
     if (!(key->flags & KEY_DIRTY)) return;
-    key->flags &= ~KEY_DIRTY;
+    key->flags &= ~(KEY_DIRTY | KEY_CHANGED);
     for (i = 0; i <= key->last_subkey; i++) make_clean( key->subkeys[i] );
 }
 
@@ -577,7 +862,9 @@ static void touch_key( struct key *key, unsigned int change )
     struct key *k;
 
     key->modif = current_time;
+    if (!(key->flags & KEY_VOLATILE)) key->flags |= KEY_CHANGED;
     make_dirty( key );
+    update_shared_key( key );
 
     /* do notifications */
     check_notify( key, change, 1 );
@@ -585,6 +872,212 @@ static void touch_key( struct key *key, unsigned int change )
         check_notify( k, change, 0 );
 }
 
+/* compare two key or value names, in the order used for the sorted arrays */
+static inline int compare_names( const WCHAR *name1, data_size_t len1, const WCHAR *name2, data_size_t len2 )
+{
+    int res = memicmp_strW( name1, name2, min( len1, len2 ) );
+    if (!res) res = len1 - len2;
+    return res;
+}
+
+typedef const WCHAR *(*get_entry_name_func)( const struct key *key, int pos, data_size_t *len );
+
+static const WCHAR *get_subkey_name( const struct key *key, int pos, data_size_t *len )
+{
+    *len = key->subkeys[pos]->namelen;
+    return key->subkeys[pos]->name;
+}
+
+static const WCHAR *get_value_name( const struct key *key, int pos, data_size_t *len )
+{
+    *len = key->values[pos].namelen;
+    return key->values[pos].name;
+}
+
+/* add the entry at the specified position of the array to the index */
+static void name_index_add( struct name_index *index, const struct key *key, int pos,
+                            get_entry_name_func get_name )
+{
+    data_size_t len;
+    const WCHAR *name = get_name( key, pos, &len );
+    unsigned int i = get_hash_strW( name, len ) & (index->size - 1);
+
+    while (index->entries[i] != -1) i = (i + 1) & (index->size - 1);
+    index->entries[i] = pos;
+}
+
+/* find a name in the index and return its position in the array, or -1 */
+static int name_index_find( const struct name_index *index, const struct key *key,
+                            const struct unicode_str *name, get_entry_name_func get_name )
+{
+    unsigned int i = get_hash_strW( name->str, name->len ) & (index->size - 1);
+    const WCHAR *entry_name;
+    data_size_t len;
+    int pos;
+
+    while ((pos = index->entries[i]) != -1)
+    {
+        entry_name = get_name( key, pos, &len );
+        if (len == name->len && !memicmp_strW( entry_name, name->str, len )) return pos;
+        i = (i + 1) & (index->size - 1);
+    }
+    return -1;
+}
+
+/* build an index of the first count entries of an array, large enough to add some more */
+static struct name_index *build_name_index( const struct key *key, int count, get_entry_name_func get_name )
+{
+    struct name_index *index;
+    unsigned int i, size = 2 * MIN_INDEXED;
+
+    while (size < 2 * (unsigned int)count + 2) size *= 2;
+    if (!(index = malloc( offsetof( struct name_index, entries[size] )))) return NULL;
+    index->size = size;
+    for (i = 0; i < size; i++) index->entries[i] = -1;
+    for (i = 0; i < count; i++) name_index_add( index, key, i, get_name );
+    return index;
+}
+
+static int compare_subkeys( const void *p1, const void *p2 )
+{
+    const struct key *key1 = *(const struct key * const *)p1;
+    const struct key *key2 = *(const struct key * const *)p2;
+    return compare_names( key1->name, key1->namelen, key2->name, key2->namelen );
+}
+
+static int compare_values( const void *p1, const void *p2 )
+{
+    const struct key_value *value1 = p1;
+    const struct key_value *value2 = p2;
+    return compare_names( value1->name, value1->namelen, value2->name, value2->namelen );
+}
+
+/* rebuild the subkey index after the array changed; without memory, fall back to a sorted array */
+static void update_subkey_index( struct key *key )
+{
+    struct name_index *index;
+
+    if (!key->subkey_index) return;
+    index = build_name_index( key, key->last_subkey + 1, get_subkey_name );
+    free( key->subkey_index );
+    key->subkey_index = index;
+    if (!index) sort_subkeys( key );
+}
+
+/* rebuild the value index after the array changed; without memory, fall back to a sorted array */
+static void update_value_index( struct key *key )
+{
+    struct name_index *index;
+
+    if (!key->value_index) return;
+    index = build_name_index( key, key->last_value + 1, get_value_name );
+    free( key->value_index );
+    key->value_index = index;
+    if (!index) sort_values( key );
+}
+
+/* sort the subkeys array before enumerating it */
+static void sort_subkeys( struct key *key )
+{
+    if (!(key->flags & KEY_SUBKEYS_UNSORTED)) return;
+    qsort( key->subkeys, key->last_subkey + 1, sizeof(*key->subkeys), compare_subkeys );
+    key->flags &= ~KEY_SUBKEYS_UNSORTED;
+    update_subkey_index( key );
+}
+
+/* sort the values array before enumerating it */
+static void sort_values( struct key *key )
+{
+    if (!(key->flags & KEY_VALUES_UNSORTED)) return;
+    qsort( key->values, key->last_value + 1, sizeof(*key->values), compare_values );
+    key->flags &= ~KEY_VALUES_UNSORTED;
+    update_value_index( key );
+}
+
+/* add the last entry of the subkeys array to the index, creating it if the key became large */
+static void add_subkey_index( struct key *key )
+{
+    int count = key->last_subkey + 1;
+
+    if (!key->subkey_index)
+    {
+        if (count >= MIN_INDEXED) key->subkey_index = build_name_index( key, count, get_subkey_name );
+    }
+    else if (2 * (unsigned int)count + 2 > key->subkey_index->size) update_subkey_index( key );
+    else name_index_add( key->subkey_index, key, count - 1, get_subkey_name );
+}
+
+/* add the last entry of the values array to the index, creating it if the key became large */
+static void add_value_index( struct key *key )
+{
+    int count = key->last_value + 1;
+
+    if (!key->value_index)
+    {
+        if (count >= MIN_INDEXED) key->value_index = build_name_index( key, count, get_value_name );
+    }
+    else if (2 * (unsigned int)count + 2 > key->value_index->size) update_value_index( key );
+    else name_index_add( key->value_index, key, count - 1, get_value_name );
+}
+
+/* remove the entry at the specified position of the array from the index, */
+/* once the following entries of the array have been moved down by one */
+static void name_index_remove( struct name_index *index, const struct key *key, int pos,
+                               get_entry_name_func get_name )
+{
+    unsigned int i, j, home, mask = index->size - 1, slot = index->size;
+    const WCHAR *name;
+    data_size_t len;
+
+    for (i = 0; i < index->size; i++)
+    {
+        if (index->entries[i] == pos) slot = i;
+        else if (index->entries[i] > pos) index->entries[i]--;
+    }
+    if (slot == index->size) return;
+
+    /* fill the hole with the following entries of the cluster that may move back to it */
+    for (i = slot, j = (slot + 1) & mask; index->entries[j] != -1; j = (j + 1) & mask)
+    {
+        name = get_name( key, index->entries[j], &len );
+        home = get_hash_strW( name, len ) & mask;
+        if (i < j ? (home <= i || home > j) : (home <= i && home > j))
+        {
+            index->entries[i] = index->entries[j];
+            i = j;
+        }
+    }
+    index->entries[i] = -1;
+}
+
+/* remove an entry of the subkeys array from the index, dropping the index if the key became small */
+static void remove_subkey_index( struct key *key, int pos )
+{
+    if (!key->subkey_index) return;
+    if (key->last_subkey + 1 >= MIN_INDEXED)
+    {
+        name_index_remove( key->subkey_index, key, pos, get_subkey_name );
+        return;
+    }
+    free( key->subkey_index );
+    key->subkey_index = NULL;
+    sort_subkeys( key );
+}
+
+/* remove an entry of the values array from the index, dropping the index if the key became small */
+static void remove_value_index( struct key *key, int pos )
+{
+    if (!key->value_index) return;
+    if (key->last_value + 1 >= MIN_INDEXED)
+    {
+        name_index_remove( key->value_index, key, pos, get_value_name );
+        return;
+    }
+    free( key->value_index );
+    key->value_index = NULL;
+    sort_values( key );
+}
+
 /* try to grow the array of subkeys; return 1 if OK, 0 on error */
 static int grow_subkeys( struct key *key )
 {
@@ -630,9 +1123,22 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
     if ((key = alloc_key( name, modif )) != NULL)
     {
         key->parent = parent;
-        for (i = ++parent->last_subkey; i > index; i--)
-            parent->subkeys[i] = parent->subkeys[i-1];
-        parent->subkeys[index] = key;
+        if (parent->subkey_index)
+        {
+            /* indexed keys simply append, the array gets sorted again when enumerated */
+            index = ++parent->last_subkey;
+            parent->subkeys[index] = key;
+            if (index && compare_subkeys( &parent->subkeys[index - 1], &key ) > 0)
+                parent->flags |= KEY_SUBKEYS_UNSORTED;
+            add_subkey_index( parent );
+        }
+        else
+        {
+            for (i = ++parent->last_subkey; i > index; i--)
+                parent->subkeys[i] = parent->subkeys[i-1];
+            parent->subkeys[index] = key;
+            if (parent->last_subkey + 1 >= MIN_INDEXED) add_subkey_index( parent );
+        }
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -653,8 +1159,10 @@ static void free_subkey( struct key *parent, int index )
     parent->last_subkey--;
     key->flags |= KEY_DELETED;
     key->parent = NULL;
+    unpublish_shared_key( key );
     if (is_wow6432node( key->name, key->namelen )) parent->flags &= ~KEY_WOW64;
     release_object( key );
+    remove_subkey_index( parent, index );
 
     /* try to shrink the array */
     nb_subkeys = parent->nb_subkeys;
@@ -675,6 +1183,17 @@ static struct key *find_subkey( const struct key *key, const struct unicode_str
     int i, min, max, res;
     data_size_t len;
 
+    if (key->subkey_index)
+    {
+        if ((i = name_index_find( key->subkey_index, key, name, get_subkey_name )) == -1)
+        {
+            *index = key->last_subkey + 1;  /* new subkeys are appended */
+            return NULL;
+        }
+        *index = i;
+        return key->subkeys[i];
+    }
+
     min = 0;
     max = key->last_subkey;
     while (min <= max)
@@ -852,7 +1371,7 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
 
     if (options & REG_OPTION_CREATE_LINK) key->flags |= KEY_SYMLINK;
     if (options & REG_OPTION_VOLATILE) key->flags |= KEY_VOLATILE;
-    else key->flags |= KEY_DIRTY;
+    else key->flags |= KEY_DIRTY | KEY_CHANGED;
 
     if (sd) default_set_sd( &key->obj, sd, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION |
                             DACL_SECURITY_INFORMATION | SACL_SECURITY_INFORMATION );
@@ -935,6 +1454,7 @@ static void enum_key( struct key *key, int index, int info_class, struct enum_ke
             set_error( STATUS_NO_MORE_ENTRIES );
             return;
         }
+        sort_subkeys( key );
         key = key->subkeys[index];
     }
 
@@ -1009,9 +1529,67 @@ static void enum_key( struct key *key, int index, int info_class, struct enum_ke
     if (debug_level > 1) dump_operation( key, NULL, "Enum" );
 }
 
-/* delete a key and its values */
-static int delete_key( struct key *key, int recurse )
+/* free the list of keys deleted since the last save of a branch */
+static void free_deleted_keys( struct save_branch_info *info )
+{
+    struct deleted_key *deleted, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( deleted, next, &info->deleted_keys, struct deleted_key, entry )
+    {
+        list_remove( &deleted->entry );
+        free( deleted );
+    }
+}
+
+/* remember a deleted key, so that the deletion can be written to the journal of its branch */
+static void record_deleted_key( struct key *key )
+{
+    struct deleted_key *deleted;
+    struct key *k;
+    data_size_t len = 0;
+    WCHAR *p;
+    int i;
+
+    if (key->flags & KEY_VOLATILE) return;
+    for (k = key; k; k = k->parent)
+    {
+        for (i = 0; i < save_branch_count; i++) if (save_branch_info[i].key == k) break;
+        if (i < save_branch_count) break;
+        len += k->namelen + sizeof(WCHAR);
+    }
+    if (!k || k == key) return;  /* not part of a saved branch */
+
+    len -= sizeof(WCHAR);  /* no separator before the first element */
+    if (!(deleted = mem_alloc( offsetof( struct deleted_key, path[len / sizeof(WCHAR)] ))))
+    {
+        save_branch_info[i].journal_id = 0;  /* cannot journal it, force a full save */
+        return;
+    }
+    deleted->len = len;
+    p = deleted->path + len / sizeof(WCHAR);
+    for (k = key; k != save_branch_info[i].key; k = k->parent)
+    {
+        p -= k->namelen / sizeof(WCHAR);
+        memcpy( p, k->name, k->namelen );
+        if (p > deleted->path) *--p = '\\';
+    }
+    list_add_tail( &save_branch_info[i].deleted_keys, &deleted->entry );
+}
+
+/* find the saved branch containing a key */
+static struct save_branch_info *get_save_branch( struct key *key )
+{
+    int i;
+
+    for (; key; key = key->parent)
+        for (i = 0; i < save_branch_count; i++) if (save_branch_info[i].key == key) return &save_branch_info[i];
+    return NULL;
+}
+
+/* delete a key and its values; only record the deletion for the journal if requested */
+static int do_delete_key( struct key *key, int recurse, int record )
 {
+    struct save_branch_info *info;
     int index;
     struct key *parent = key->parent;
 
@@ -1029,9 +1607,14 @@ static int delete_key( struct key *key, int recurse )
         return -1;
     }
 
+    /* the deletion of the topmost key covers its subkeys in the journal */
     while (recurse && (key->last_subkey>=0))
-        if (0 > delete_key(key->subkeys[key->last_subkey], 1))
+        if (0 > do_delete_key(key->subkeys[key->last_subkey], 1, 0))
+        {
+            /* some subkeys are gone without being recorded, rewrite the whole branch */
+            if (record && (info = get_save_branch( key ))) info->journal_id = 0;
             return -1;
+        }
 
     for (index = 0; index <= parent->last_subkey; index++)
         if (parent->subkeys[index] == key) break;
@@ -1045,11 +1628,18 @@ static int delete_key( struct key *key, int recurse )
     }
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
+    if (record) record_deleted_key( key );
     free_subkey( parent, index );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
     return 0;
 }
 
+/* delete a key and its values */
+static int delete_key( struct key *key, int recurse )
+{
+    return do_delete_key( key, recurse, 1 );
+}
+
 /* try to grow the array of values; return 1 if OK, 0 on error */
 static int grow_values( struct key *key )
 {
@@ -1081,6 +1671,17 @@ static struct key_value *find_value( const struct key *key, const struct unicode
     int i, min, max, res;
     data_size_t len;
 
+    if (key->value_index)
+    {
+        if ((i = name_index_find( key->value_index, key, name, get_value_name )) == -1)
+        {
+            *index = key->last_value + 1;  /* new values are appended */
+            return NULL;
+        }
+        *index = i;
+        return &key->values[i];
+    }
+
     min = 0;
     max = key->last_value;
     while (min <= max)
@@ -1118,12 +1719,25 @@ static struct key_value *insert_value( struct key *key, const struct unicode_str
         if (!grow_values( key )) return NULL;
     }
     if (name->len && !(new_name = memdup( name->str, name->len ))) return NULL;
-    for (i = ++key->last_value; i > index; i--) key->values[i] = key->values[i - 1];
+    if (key->value_index)
+    {
+        /* indexed keys simply append, the array gets sorted again when enumerated */
+        index = ++key->last_value;
+        if (index && compare_names( key->values[index - 1].name, key->values[index - 1].namelen,
+                                    name->str, name->len ) > 0)
+            key->flags |= KEY_VALUES_UNSORTED;
+    }
+    else for (i = ++key->last_value; i > index; i--) key->values[i] = key->values[i - 1];
     value = &key->values[index];
     value->name    = new_name;
     value->namelen = name->len;
     value->len     = 0;
     value->data    = NULL;
+    if (key->value_index || key->last_value + 1 >= MIN_INDEXED)
+    {
+        add_value_index( key );
+        value = find_value( key, name, &index );  /* the array may have been sorted */
+    }
     return value;
 }
 
@@ -1224,6 +1838,7 @@ static void enum_value( struct key *key, int i, int info_class, struct enum_key_
         void *data;
         data_size_t namelen, maxlen;
 
+        sort_values( key );
         value = &key->values[i];
         reply->type = value->type;
         namelen = value->namelen;
@@ -1286,6 +1901,7 @@ static void delete_value( struct key *key, const struct unicode_str *name )
     free( value->data );
     for (i = index; i < key->last_value; i++) key->values[i] = key->values[i + 1];
     key->last_value--;
+    remove_value_index( key, index );
     touch_key( key, REG_NOTIFY_CHANGE_LAST_SET );
 
     /* try to shrink the array */
@@ -1488,10 +2104,28 @@ static int load_global_option( const char *buffer, struct file_load_info *info )
             return 0;
         }
     }
+    if (!strncmp( buffer, "#journal=", 9 )) info->journal_id = strtoul( buffer + 9, NULL, 16 );
     /* ignore unknown options */
     return 1;
 }
 
+/* delete all the values of a key */
+static void clear_values( struct key *key )
+{
+    int i;
+
+    for (i = 0; i <= key->last_value; i++)
+    {
+        free( key->values[i].name );
+        free( key->values[i].data );
+    }
+    key->last_value = -1;
+    key->flags &= ~KEY_VALUES_UNSORTED;
+    free( key->value_index );
+    key->value_index = NULL;
+    update_shared_key( key );
+}
+
 /* load a key option from the input file */
 static int load_key_option( struct key *key, const char *buffer, struct file_load_info *info )
 {
@@ -1522,6 +2156,14 @@ static int load_key_option( struct key *key, const char *buffer, struct file_loa
         key->classlen = len;
     }
     if (!strncmp( buffer, "#link", 5 )) key->flags |= KEY_SYMLINK;
+    /* journal entries replace the whole contents of a key */
+    if (!strncmp( buffer, "#clear", 6 ))
+    {
+        clear_values( key );
+        key->modif = 0;  /* reset by the following #time option */
+    }
+    /* replayed deletions are already in the journal */
+    if (!strncmp( buffer, "#delete", 7 ) && key->parent) do_delete_key( key, 1, 0 );
     /* ignore unknown options */
     return 1;
 }
@@ -1640,6 +2282,7 @@ static int load_value( struct key *key, const char *buffer, struct file_load_inf
     value->data = newptr;
     value->len  = len;
     value->type = type;
+    update_shared_key( key );
     return 1;
 
  error:
@@ -1648,6 +2291,7 @@ static int load_value( struct key *key, const char *buffer, struct file_load_inf
     value->data = NULL;
     value->len  = 0;
     value->type = REG_NONE;
+    update_shared_key( key );
     return 0;
 }
 
@@ -1678,9 +2322,9 @@ static int get_prefix_len( struct key *key, const char *name, struct file_load_i
     return res;
 }
 
-/* load all the keys from the input file */
+/* load all the keys from the input file, and return the id of the matching journal */
 /* prefix_len is the number of key name prefixes to skip, or -1 for autodetection */
-static void load_keys( struct key *key, const char *filename, FILE *f, int prefix_len )
+static unsigned int load_keys( struct key *key, const char *filename, FILE *f, int prefix_len )
 {
     struct key *subkey = NULL;
     struct file_load_info info;
@@ -1692,11 +2336,12 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     info.len    = 4;
     info.tmplen = 4;
     info.line   = 0;
-    if (!(info.buffer = mem_alloc( info.len ))) return;
+    info.journal_id = 0;
+    if (!(info.buffer = mem_alloc( info.len ))) return 0;
     if (!(info.tmp = mem_alloc( info.tmplen )))
     {
         free( info.buffer );
-        return;
+        return 0;
     }
 
     if ((read_next_line( &info ) != 1) ||
@@ -1748,6 +2393,7 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     }
     free( info.buffer );
     free( info.tmp );
+    return info.journal_id;
 }
 
 /* load a part of the registry from a file */
@@ -1771,14 +2417,46 @@ static void load_registry( struct key *key, obj_handle_t handle )
     }
 }
 
+/* replay the changes saved in the journal of an initial registry file */
+static void load_init_registry_journal( struct save_branch_info *info )
+{
+    char buffer[64];
+    unsigned int id;
+    struct stat st;
+    FILE *f;
+
+    if (!info->journal_path || !(f = fopen( info->journal_path, "r" ))) return;
+
+    /* only replay the journal if it matches the file we loaded */
+    if (info->journal_id &&
+        fgets( buffer, sizeof(buffer), f ) && !strcmp( buffer, "WINE REGISTRY Version 2\n" ) &&
+        fgets( buffer, sizeof(buffer), f ) && sscanf( buffer, "#journal=%x", &id ) == 1 &&
+        id == info->journal_id)
+    {
+        rewind( f );
+        load_keys( info->key, info->journal_path, f, 0 );
+        if (!fstat( fileno( f ), &st )) info->journal_size = st.st_size;
+        /* the branch now matches the file and its journal */
+        free_deleted_keys( info );
+        make_clean( info->key );
+    }
+    else info->journal_id = 0;  /* stale journal, the next save will remove it */
+    fclose( f );
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
+    struct save_branch_info *info;
+    unsigned int journal_id = 0;
+    off_t file_size = 0;
+    struct stat st;
     FILE *f;
 
     if ((f = fopen( filename, "r" )))
     {
-        load_keys( key, filename, f, 0 );
+        journal_id = load_keys( key, filename, f, 0 );
+        if (!fstat( fileno( f ), &st )) file_size = st.st_size;
         fclose( f );
         if (get_error() == STATUS_NOT_REGISTRY_FILE)
         {
@@ -1789,9 +2467,17 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
 
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
 
-    save_branch_info[save_branch_count].path = filename;
-    save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
+    info = &save_branch_info[save_branch_count++];
+    info->path = filename;
+    info->key = (struct key *)grab_object( key );
+    info->journal_id = journal_id;
+    info->file_size = file_size;
+    info->journal_size = 0;
+    list_init( &info->deleted_keys );
+    if ((info->journal_path = malloc( strlen( filename ) + sizeof(".journal") )))
+        sprintf( info->journal_path, "%s.journal", filename );
     make_object_permanent( &key->obj );
+    load_init_registry_journal( info );
     return (f != NULL);
 }
 
@@ -1965,7 +2651,7 @@ void init_registry(void)
 }
 
 /* save a registry branch to a file */
-static void save_all_subkeys( struct key *key, FILE *f )
+static void save_all_subkeys( struct key *key, FILE *f, unsigned int journal_id )
 {
     fprintf( f, "WINE REGISTRY Version 2\n" );
     fprintf( f, ";; All keys relative to " );
@@ -1982,6 +2668,7 @@ static void save_all_subkeys( struct key *key, FILE *f )
     default:
         break;
     }
+    if (journal_id) fprintf( f, "#journal=%x\n", journal_id );
     save_subkeys( key, key, f );
 }
 
@@ -1999,7 +2686,7 @@ static void save_registry( struct key *key, obj_handle_t handle )
         FILE *f = fdopen( fd, "w" );
         if (f)
         {
-            save_all_subkeys( key, f );
+            save_all_subkeys( key, f, 0 );
             if (fclose( f )) file_set_error();
         }
         else
@@ -2011,14 +2698,19 @@ static void save_registry( struct key *key, obj_handle_t handle )
 }
 
 /* save a registry branch to a file */
-static int save_branch( struct key *key, const char *path )
+static int save_branch( struct save_branch_info *info )
 {
+    struct key *key = info->key;
+    const char *path = info->path;
+    unsigned int journal_id;
     struct stat st;
     char *p, *tmp = NULL;
     int fd, count = 0, ret = 0;
+    off_t size = 0;
     FILE *f;
 
-    if (!(key->flags & KEY_DIRTY))
+    /* a clean branch still needs saving if it has a journal to merge */
+    if (!(key->flags & KEY_DIRTY) && !info->journal_size)
     {
         if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
         return 1;
@@ -2068,7 +2760,12 @@ static int save_branch( struct key *key, const char *path )
         dump_operation( key, NULL, "saving" );
     }
 
-    save_all_subkeys( key, f );
+    /* a new id makes sure a crash before the journal is removed doesn't replay it */
+    journal_id = (unsigned int)(current_time / TICKS_PER_SEC) ^ (unsigned int)getpid();
+    while (!journal_id || journal_id == info->journal_id) journal_id++;
+
+    save_all_subkeys( key, f, journal_id );
+    size = ftell( f );
     ret = !fclose(f);
 
     if (tmp)
@@ -2080,7 +2777,61 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key );
+    if (ret)
+    {
+        make_clean( key );
+        free_deleted_keys( info );
+        if (info->journal_path) unlink( info->journal_path );
+        info->journal_id = journal_id;
+        info->file_size = size;
+        info->journal_size = 0;
+    }
+    return ret;
+}
+
+/* append the changes made to a registry branch since the last save to its journal */
+static int save_branch_journal( struct save_branch_info *info )
+{
+    struct deleted_key *deleted;
+    struct key *key = info->key;
+    int ret;
+    FILE *f;
+
+    if (!(key->flags & KEY_DIRTY))
+    {
+        if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
+        return 1;
+    }
+
+    /* rewrite the whole branch if the journal grew too large compared to it */
+    if (!info->journal_id || !info->journal_path || info->journal_size > info->file_size / 2)
+        return save_branch( info );
+
+    if (!(f = fopen( info->journal_path, "a" ))) return save_branch( info );
+
+    if (debug_level > 1)
+    {
+        fprintf( stderr, "%s: ", info->journal_path );
+        dump_operation( key, NULL, "journaling" );
+    }
+
+    if (!info->journal_size) fprintf( f, "WINE REGISTRY Version 2\n#journal=%x\n", info->journal_id );
+    LIST_FOR_EACH_ENTRY( deleted, &info->deleted_keys, struct deleted_key, entry )
+    {
+        fprintf( f, "\n[" );
+        dump_strW( deleted->path, deleted->len, f, "[]" );
+        fprintf( f, "]\n#delete\n" );
+    }
+    save_changed_subkeys( key, key, f );
+    info->journal_size = ftell( f );
+    ret = !fclose( f );
+
+    if (ret)
+    {
+        make_clean( key );
+        free_deleted_keys( info );
+    }
+    else info->journal_id = 0;  /* journal may be truncated, force a full save next time */
     return ret;
 }
 
@@ -2091,8 +2842,7 @@ static void periodic_save( void *arg )
 
     if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
-    for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+    for (i = 0; i < save_branch_count; i++) save_branch_journal( &save_branch_info[i] );
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     set_periodic_save_timer();
 }
@@ -2112,7 +2862,7 @@ void flush_registry(void)
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
-        if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
+        if (!save_branch( &save_branch_info[i] ))
         {
             fprintf( stderr, "wineserver: could not save registry branch to %s",
                      save_branch_info[i].path );
@@ -2258,6 +3008,8 @@ DECL_HANDLER(get_key_value)
     if ((key = get_hkey_obj( req->hkey, KEY_QUERY_VALUE )))
     {
         get_value( key, &name, &reply->type, &reply->total );
+        if (!key->shared_id && ++key->query_count >= SHARED_QUERY_THRESHOLD) publish_shared_key( key );
+        reply->shared_id = key->shared_id;
         release_object( key );
     }
 }
@@ -2315,6 +3067,10 @@ DECL_HANDLER(load_registry)
         int dummy;
         if ((key = create_key( parent, &name, NULL, 0, KEY_WOW64_64KEY, 0, sd, &dummy )))
         {
+            int i;
+
+            /* the loaded keys are not tracked individually, so they can't be journaled */
+            for (i = 0; i < save_branch_count; i++) save_branch_info[i].journal_id = 0;
             load_registry( key, req->file );
             release_object( key );
         }